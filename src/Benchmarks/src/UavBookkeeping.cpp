@@ -0,0 +1,138 @@
+// Copyright 2016 Carrie Rebhuhn
+/**
+* Times the per-step path bookkeeping of UAVs: three lookups along the
+* planned path and an advance, with a replan whenever the UAV reaches its
+* terminal link. Replans are timed separately, since the search dominates
+* them. The sector-list representation that UAV used before is reproduced
+* here as ListUav, so both run the same workload on the same graph and
+* their checksums must agree.
+*
+* usage: uav_bookkeeping [uavs] [steps] [sectors]
+* Reads config.yaml from the working directory (for modes: search), and
+* writes a minimal one if there is none.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "Domains/UTM/UAV.h"
+#include "Math/include/Random.h"
+
+using std::list;
+using std::vector;
+
+namespace {
+//! UAV path bookkeeping as it was, on a std::list popped from the front
+struct ListUav {
+    LinkGraph* graph;
+    list<size_t> path;
+
+    ListUav(size_t start, size_t end, LinkGraph* g) : graph(g) {
+        reset(start, end);
+    }
+    void reset(size_t start, size_t end) {
+        path = Planning::astar<LinkGraph, size_t>(graph, start, end);
+    }
+    size_t getNthSector(size_t n) const {
+        if (path.size() <= n)
+            return path.front();
+        return *std::next(path.begin(), n);
+    }
+    bool atTerminalLink() const { return path.size() <= 2; }
+    void incrementPath() { path.pop_front(); }
+};
+
+//! Destination for a UAV replanning from start, never start itself
+size_t destination(size_t uav, size_t step, size_t start, size_t n) {
+    size_t end = (uav*7 + step) % n;
+    return end == start ? (end + 1) % n : end;
+}
+
+typedef std::chrono::steady_clock clock;
+
+double seconds_since(clock::time_point t0) {
+    std::chrono::duration<double> d = clock::now() - t0;
+    return d.count();
+}
+
+struct timing {
+    double bookkeeping, replan;
+};
+
+//! Runs the workload over uavs and returns a checksum of the lookups. Each
+//! step first replans the UAVs on their terminal link, then moves them all.
+template <class U>
+size_t run(vector<U*> *uavs, size_t steps, size_t n_sectors, timing* t) {
+    size_t sum = 0;
+    t->bookkeeping = 0.0;
+    t->replan = 0.0;
+    for (size_t s = 0; s < steps; s++) {
+        clock::time_point t0 = clock::now();
+        for (size_t i = 0; i < uavs->size(); i++) {
+            U* u = (*uavs)[i];
+            if (u->atTerminalLink()) {
+                size_t start = u->getNthSector(1);
+                u->reset(start, destination(i, s, start, n_sectors));
+            }
+        }
+        t->replan += seconds_since(t0);
+
+        t0 = clock::now();
+        for (U* u : *uavs) {
+            sum = sum*31 + u->getNthSector(0);
+            sum = sum*31 + u->getNthSector(1);
+            sum = sum*31 + u->getNthSector(2);
+            u->incrementPath();
+        }
+        t->bookkeeping += seconds_since(t0);
+    }
+    return sum;
+}
+
+void report(const char* name, const timing &t, size_t moves) {
+    printf("%-7s bookkeeping %.4f s (%.1f ns/move), replanning %.3f s\n",
+        name, t.bookkeeping, 1e9*t.bookkeeping / moves, t.replan);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    size_t n_uavs = argc > 1 ? atoi(argv[1]) : 500;
+    size_t steps = argc > 2 ? atoi(argv[2]) : 200;
+    size_t n_sectors = argc > 3 ? atoi(argv[3]) : 40;
+
+    if (!std::ifstream("config.yaml"))
+        std::ofstream("config.yaml") << "modes:\n  search: astar\n";
+
+    easymath::seed(easymath::k_default_seed);
+    LinkGraph graph(n_sectors, 200, 200);
+
+    vector<ListUav*> list_uavs;
+    vector<UAV*> uavs;
+    for (size_t i = 0; i < n_uavs; i++) {
+        size_t start = i % n_sectors;
+        size_t end = destination(i, 0, start, n_sectors);
+        list_uavs.push_back(new ListUav(start, end, &graph));
+        uavs.push_back(new UAV(start, end, &graph));
+    }
+
+    timing list_time, vector_time;
+    size_t list_sum = run(&list_uavs, steps, n_sectors, &list_time);
+    size_t vector_sum = run(&uavs, steps, n_sectors, &vector_time);
+
+    printf("%zu uavs, %zu steps, %zu sectors\n", n_uavs, steps, n_sectors);
+    report("list", list_time, n_uavs*steps);
+    report("vector", vector_time, n_uavs*steps);
+    if (list_sum != vector_sum) {
+        printf("checksums differ: %zx vs %zx\n", list_sum, vector_sum);
+        return 1;
+    }
+
+    for (ListUav* u : list_uavs) delete u;
+    for (UAV* u : uavs) delete u;
+    return 0;
+}
@@ -4,13 +4,14 @@
 #include <vector>
 #include <algorithm>
 #include "Domains/IDomainStateful.h"
+#include "Math/include/Random.h"
 
 #define MAXPOI 100.0
 #define XDIM 100.0
 #define YDIM 100.0
 #define NPOIS 10
 #define NROVS 10
-#define RAND double(rand())/double(RAND_MAX)
+#define RAND easymath::rand(0.0, 1.0)
 
 class POI {
 public:
@@ -30,6 +30,7 @@ UAVDetail* FixDetail::generate_UAV() {
     LinkGraph* high = highGraph->at(type_id_set);
     GridGraph* low = lowGraph->at(type_id_set);
 
-    return new UAVDetail(loc, end_loc, type_id_set, high, low, n_types);
+    return new UAVDetail(loc, end_loc, type_id_set, high, low, hierarchy,
+        n_types);
 }
 
@@ -7,9 +7,10 @@
 class FixDetail : public Fix {
  public:
     FixDetail(easymath::XY loc, size_t ID, MultiGraph<LinkGraph>* highGraph,
-        MultiGraph<GridGraph>* lowGraph, std::vector<easymath::XY> dest_locs, size_t n_types_set) :
+        MultiGraph<GridGraph>* lowGraph, HierarchicalGraph* hierarchy,
+        std::vector<easymath::XY> dest_locs, size_t n_types_set) :
         Fix(loc, ID, highGraph, dest_locs, n_types_set),
-        lowGraph(lowGraph)
+        lowGraph(lowGraph), hierarchy(hierarchy)
     {
         YAML::Node configs = YAML::LoadFile("config.yaml");
         approach_threshold = configs["constants"]["approach_threshold"].as<double>();
@@ -18,6 +19,7 @@ class FixDetail : public Fix {
 
     virtual ~FixDetail() {}
     MultiGraph<GridGraph>* lowGraph;
+    HierarchicalGraph* hierarchy;
 
     //! Calls a conditional, then creates UAV in the world
     virtual UAVDetail* generate_UAV(int step);
@@ -10,9 +10,11 @@ using std::list;
 
 
 UAVDetail::UAVDetail(XY start_loc, XY end_loc, UAVType t,
-    LinkGraph* highGraph, GridGraph* lowGraph, size_t n_links_set) :
+    LinkGraph* highGraph, GridGraph* lowGraph, HierarchicalGraph* hierarchy,
+    size_t n_links_set) :
     UAV(lowGraph->get_membership(start_loc), lowGraph->get_membership(end_loc),
-        t, highGraph), lowGraph(lowGraph), loc(start_loc), end_loc(end_loc), n_links(n_links_set) {
+        t, highGraph), lowGraph(lowGraph), hierarchy(hierarchy), loc(start_loc),
+    end_loc(end_loc), n_links(n_links_set) {
     std::printf("UAV %i created", get_ID());
 }
 
@@ -33,7 +35,10 @@ void UAVDetail::planDetailPath() {
     XY next_loc = highGraph->get_vertex_loc(get_next_sector());
 
     if (next_sector != cur_sector) { // if not an internal link
-        list<XY> low_path = Planning::astar(lowGraph, loc, next_loc);
+        // Stitched from cached border paths; full search only as a fallback
+        list<XY> low_path = hierarchy->get_leg(loc, cur_sector, next_sector);
+        if (low_path.empty())
+            low_path = Planning::astar(lowGraph, loc, next_loc);
         // Add to target waypoints
         target_waypoints.clear();
         for (XY i : low_path)
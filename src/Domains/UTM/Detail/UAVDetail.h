@@ -9,11 +9,13 @@
 // Library includes
 #include "Domains/UTM/UAV.h"
 #include "Planning/GridGraph.h"
+#include "Planning/include/HierarchicalGraph.h"
 
 class UAVDetail : public UAV {
 public:
     UAVDetail(easymath::XY start_loc, easymath::XY end_loc, UAVType t,
-        LinkGraph* highGraph, GridGraph* lowGraph, size_t n_links_set);
+        LinkGraph* highGraph, GridGraph* lowGraph,
+        HierarchicalGraph* hierarchy, size_t n_links_set);
     virtual ~UAVDetail() {};
 
     // Comparison accessors
@@ -43,6 +45,8 @@ private:
     std::list<easymath::XY> target_waypoints;
     //! Low-level graph
     GridGraph* lowGraph;
+    //! Cached sector-border paths over the low-level graph
+    HierarchicalGraph* hierarchy;
     size_t n_links;
 };
 
@@ -22,12 +22,14 @@ UTMDomainDetail::UTMDomainDetail(std::string config_file) :
     YAML::Node configs = YAML::LoadFile(config_file);
     keep = configs["modes"]["disposal"].as<std::string>() == "keep";
     conflict_thresh = configs["constants"]["conflict_thresh"].as<double>();
+    conflict_grid = new easymath::SpatialHash(conflict_thresh);
 
     // Planning
     GridGraph* base = new GridGraph(membership_map);
     lowGraph = new MultiGraph<GridGraph>(highGraph->at()->get_n_edges(), base);
 
     vector<edge> edges = highGraph->at()->get_edges();
+    hierarchy = new HierarchicalGraph(base, edges);
     vector<vector<size_t> > connections(sectors.size());
     for (edge e : edges)
         connections[e.first].push_back(e.second);
@@ -35,7 +37,8 @@ UTMDomainDetail::UTMDomainDetail(std::string config_file) :
     vector<XY> sector_locs = highGraph->at()->get_locations();
     for (size_t i = 0; i < sectors.size(); i++)
         sectors.push_back(new SectorDetail(sector_locs[i], i, connections[i],
-            sector_locs, highGraph, lowGraph, &UAVs_done[i], n_types));
+            sector_locs, highGraph, lowGraph, hierarchy, &UAVs_done[i],
+            n_types));
 }
 
 
@@ -194,7 +197,8 @@ void UTMDomainDetail::reset() {
 }
 
 void UTMDomainDetail::try_to_move(vector<UAVDetail*> * eligible_to_move) {
-    random_shuffle(eligible_to_move->begin(), eligible_to_move->end());
+    easymath::shuffle(eligible_to_move->begin(), eligible_to_move->end(),
+        easymath::RNG_SCHEDULE);
 
 
     size_t el_size;
@@ -229,17 +233,16 @@ void UTMDomainDetail::exportLog(std::string fid, double) {
 }
 
 void UTMDomainDetail::detectConflicts() {
-    for (auto u1 = UAVs.begin(); u1 != UAVs.end(); ++u1) {
-        for (auto u2 = std::next(u1); u2 != UAVs.end(); ++u2) {
-            XY a = (*u1)->get_location();
-            XY b = (*u2)->get_location();
-            double d = easymath::euclidean_distance(a, b);
-
-            if (d > conflict_thresh) continue;  // No conflict!
-
-            addConflict(*u1, *u2);
-        }
-    }
+    // Only UAVs in the same or neighbouring cells can be in conflict
+    vector<UAVDetail*> located(UAVs.begin(), UAVs.end());
+    conflict_grid->clear();
+    for (UAVDetail* u : located)
+        conflict_grid->insert(u->get_location());
+
+    conflict_grid->for_each_pair_within(conflict_thresh,
+        [this, &located](size_t i, size_t j) {
+        addConflict(located[i], located[j]);
+    });
 }
 
 void UTMDomainDetail::absorbUAVTraffic() {
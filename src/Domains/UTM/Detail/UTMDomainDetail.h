@@ -11,12 +11,16 @@
 
 // Library includes
 #include "Domains/UTM/UTMDomainAbstract.h"
+#include "Math/include/SpatialHash.h"
 #include "SectorDetail.h"
 
 class UTMDomainDetail : public UTMDomainAbstract {
 public:
     UTMDomainDetail(std::string config_file);
-    virtual ~UTMDomainDetail() {};
+    virtual ~UTMDomainDetail() {
+        delete hierarchy;
+        delete conflict_grid;
+    };
 
 private:
     // Modified objects for child class
@@ -24,6 +28,8 @@ private:
     std::list<UAVDetail*> UAVs;
     std::map<int, std::list<UAVDetail*> > UAVs_done;
     double conflict_thresh;
+    //! UAV locations bucketed into cells of size conflict_thresh
+    easymath::SpatialHash* conflict_grid;
     // Base function overloads
     virtual matrix1d getRewards();
     virtual matrix1d getPerformance();
@@ -38,6 +44,7 @@ private:
 
     // maps/Graph
     MultiGraph<GridGraph>* lowGraph;
+    HierarchicalGraph* hierarchy;
 
     void addConflict(UAV* u1, UAV* u2) {
         agents->metrics.at(u1->get_cur_sector()).local[u1->get_type()] += 0.5;
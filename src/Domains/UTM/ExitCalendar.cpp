@@ -0,0 +1,47 @@
+// Copyright 2016 Carrie Rebhuhn
+#include "ExitCalendar.h"
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+void ExitCalendar::schedule(UAV* u) {
+    size_t horizon = u->getExitTime() - now_ + 1;
+    if (horizon > buckets_.size())
+        grow(horizon);
+    buckets_[u->getExitTime() % buckets_.size()].push_back(u);
+}
+
+vector<UAV*> ExitCalendar::advance() {
+    now_++;
+    vector<UAV*> arrived;
+    arrived.swap(buckets_[now_ % buckets_.size()]);
+
+    // Only keep UAVs that have not been rescheduled since
+    size_t now = now_;
+    arrived.erase(std::remove_if(arrived.begin(), arrived.end(),
+        [now](UAV* u) { return u->getExitTime() != now; }), arrived.end());
+    std::sort(arrived.begin(), arrived.end(), [](UAV* a, UAV* b) {
+        return a->getId() < b->getId();
+    });
+    return arrived;
+}
+
+void ExitCalendar::reset() {
+    now_ = 0;
+    for (vector<UAV*> &b : buckets_)
+        b.clear();
+}
+
+void ExitCalendar::grow(size_t horizon) {
+    size_t n_buckets = buckets_.size();
+    while (n_buckets < horizon)
+        n_buckets *= 2;
+
+    vector<vector<UAV*> > buckets(n_buckets);
+    for (vector<UAV*> &b : buckets_)
+        for (UAV* u : b)
+            buckets[u->getExitTime() % n_buckets].push_back(u);
+    buckets_.swap(buckets);
+}
@@ -0,0 +1,37 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef SRC_DOMAINS_UTM_EXITCALENDAR_H_
+#define SRC_DOMAINS_UTM_EXITCALENDAR_H_
+
+#include <vector>
+
+#include "UAV.h"
+
+/**
+* Calendar queue of link exit times. The clock counts simulation ticks, and
+* a UAV is filed in the bucket of the tick at which it reaches the end of its
+* link. Advancing the clock only visits the UAVs in that bucket, so UAVs that
+* are still mid-link cost nothing per tick.
+*/
+class ExitCalendar {
+ public:
+    ExitCalendar() : now_(0), buckets_(1) {}
+
+    size_t now() const { return now_; }
+
+    //! Files u under its exit time, which must be later than now()
+    void schedule(UAV* u);
+
+    //! Moves the clock on one tick. The UAVs that reach the end of their
+    //! link on that tick are returned in ID order.
+    std::vector<UAV*> advance();
+
+    void reset();
+
+ private:
+    size_t now_;
+    std::vector<std::vector<UAV*> > buckets_;  // ring indexed by exit time
+
+    //! Resizes the ring so it spans at least horizon ticks
+    void grow(size_t horizon);
+};
+#endif  // SRC_DOMAINS_UTM_EXITCALENDAR_H_
@@ -11,11 +11,12 @@ using std::list;
 using std::map;
 using easymath::XY;
 using easymath::rand;
+using easymath::rand_index;
 
 Fix::Fix(XY loc, size_t id, LinkGraph* high_graph,
-    vector<XY> dest_locs) :
-    high_graph_(high_graph), k_destination_locs_(dest_locs), k_id_(id),
-    k_loc_(loc) {
+    vector<XY> dest_locs, RAGS* rags) :
+    high_graph_(high_graph), rags_(rags), k_destination_locs_(dest_locs),
+    k_id_(id), k_loc_(loc) {
     YAML::Node config = YAML::LoadFile("config.yaml");
     k_traffic_mode_ = config["modes"]["traffic"].as<std::string>();
     k_destination_mode_ = config["modes"]["destinations"].as<std::string>();
@@ -29,7 +30,7 @@ bool Fix::shouldGenerateUav(size_t step) {
     if (k_traffic_mode_ == "constant") {
         return false;
     } else if (k_traffic_mode_ == "probabilistic") {
-        double pnum = rand(0, 1);
+        double pnum = rand(0, 1, easymath::RNG_TRAFFIC);
         if (pnum > k_gen_prob_)
             return false;
         else
@@ -53,7 +54,7 @@ UAV* Fix::generateUav(size_t step) {
 
 UAV* Fix::generateUav(bool reset) {
     static int calls = 0;
-    auto e = high_graph_->get_edges();
+    const auto &e = high_graph_->get_edges();
     XY end_loc;
     if (k_destination_mode_ == "static") {
         size_t index = calls%e.size();
@@ -64,7 +65,7 @@ UAV* Fix::generateUav(bool reset) {
         }
     } else {
         do {
-            size_t index = rand() % e.size();
+            size_t index = rand_index(e.size(), easymath::RNG_TRAFFIC);
             end_loc = k_destination_locs_[e[index].second];
         } while (end_loc == k_loc_);
     }
@@ -72,6 +73,6 @@ UAV* Fix::generateUav(bool reset) {
 
     UAV* u = new UAV(high_graph_->get_membership(k_loc_),
         high_graph_->get_membership(end_loc),
-        high_graph_);
+        high_graph_, rags_);
     return u;
 }
@@ -16,7 +16,7 @@ class Fix {
  public:
     typedef std::pair<size_t, size_t> edge;
     Fix(easymath::XY loc, size_t id, LinkGraph* high_graph,
-        std::vector<easymath::XY> dest_locs);
+        std::vector<easymath::XY> dest_locs, RAGS* rags = NULL);
 
 
     virtual ~Fix() {}
@@ -28,10 +28,10 @@ class Fix {
     bool shouldGenerateUav(size_t step);
 public:
     void resetUav(UAV* u) {
-        auto e = high_graph_->get_locations();
         size_t index;
         do {
-            index = rand() % e.size();
+            index = easymath::rand_index(high_graph_->get_n_vertices(),
+                easymath::RNG_TRAFFIC);
         } while (index == k_id_);
 
         u->reset(k_id_, index);
@@ -41,6 +41,7 @@ public:
     size_t k_id_, k_gen_rate_;
     easymath::XY k_loc_;
     LinkGraph* high_graph_;
+    RAGS* rags_;  // shared planner handed to new UAVs
     std::string k_traffic_mode_, k_destination_mode_;
     double k_gen_prob_;
     std::vector<easymath::XY> k_destination_locs_;
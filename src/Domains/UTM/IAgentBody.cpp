@@ -7,7 +7,10 @@
 using std::string;
 
 IAgentBody::IAgentBody(size_t num_agents, size_t num_states):
-    k_num_states_(num_states)
+    k_num_states_(num_states), conflicts_(num_agents, 0.0),
+    delays_(num_agents, 0.0), squared_delays_(num_agents, 0.0),
+    total_conflicts_(0.0), total_delay_(0.0), total_squared_delay_(0.0),
+    step_delays_(num_agents, 0.0)
 {
     YAML::Node config = YAML::LoadFile("config.yaml");
     k_square_reward_mode_ = config["modes"]["square"].as<bool>();
@@ -35,7 +38,33 @@ void IAgentBody::exportAgentActions(int fileID) {
     FileOut::print_vector(agent_states_, statefile);
 }
 
+void IAgentBody::addDelays(const std::vector<size_t> &delayed_agents) {
+    // Tally this step per agent, then fold it into the running sums,
+    // touching only the agents that were delayed
+    std::vector<size_t> touched;
+    for (size_t a : delayed_agents) {
+        if (step_delays_[a] == 0.0)
+            touched.push_back(a);
+        step_delays_[a]++;
+    }
+
+    for (size_t a : touched) {
+        double d = step_delays_[a];
+        delays_[a] += d;
+        squared_delays_[a] += d*d;
+        total_delay_ += d;
+        total_squared_delay_ += d*d;
+        step_delays_[a] = 0.0;
+    }
+}
+
 void IAgentBody::reset() {
     agent_actions_.clear();
     agent_states_.clear();
+    conflicts_.assign(conflicts_.size(), 0.0);
+    delays_.assign(delays_.size(), 0.0);
+    squared_delays_.assign(squared_delays_.size(), 0.0);
+    total_conflicts_ = 0.0;
+    total_delay_ = 0.0;
+    total_squared_delay_ = 0.0;
 }
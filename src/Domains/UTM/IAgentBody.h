@@ -42,5 +42,25 @@ public:
     // Reward
     double k_alpha_;
     bool k_square_reward_mode_;
+    //! Returns the agent that controls the link
+    virtual size_t getAgent(size_t link_id) = 0;
+    //! Conflicts counted against each agent this episode [agent]
+    matrix1d conflicts_;
+    //! Adds n conflicts to the agent that controls the link
+    void addConflicts(size_t link_id, size_t n) {
+        conflicts_[getAgent(link_id)] += static_cast<double>(n);
+        total_conflicts_ += static_cast<double>(n);
+    }
+    //! UAV-steps spent blocked by each agent this episode [agent]
+    matrix1d delays_;
+    //! Sum over steps of each agent's squared delay for that step [agent]
+    matrix1d squared_delays_;
+    //! Sums of conflicts_, delays_ and squared_delays_ over all agents
+    double total_conflicts_, total_delay_, total_squared_delay_;
+    //! Adds one step's delays, given the agent blocking each delayed UAV
+    void addDelays(const std::vector<size_t> &delayed_agents);
+
+ private:
+    matrix1d step_delays_;  // Scratch per-step delay counts [agent]
 };
 #endif  // DOMAINS_UTM_UTMAGENTREWARD_H_
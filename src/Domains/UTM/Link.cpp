@@ -3,19 +3,17 @@
 
 #include <algorithm>
 #include <functional>
-#include <list>
 #include <vector>
 #include "STL/include/easystl.h"
 
 using std::vector;
-using std::list;
-using std::greater;
 
 Link::Link(size_t id, size_t source, size_t target, size_t time,
-    size_t capacity, size_t cardinal_dir) :
-    k_id_(id), k_source_(source), k_target_(target), time_(time),
-    k_cardinal_dir_(cardinal_dir), k_capacity_(capacity),
-    traffic_(list<UAV*>())
+    size_t capacity, size_t cardinal_dir, matrix1d* occupancy,
+    ExitCalendar* calendar) :
+    k_source_(source), k_target_(target), k_cardinal_dir_(cardinal_dir),
+    k_id_(id), time_(time), k_capacity_(capacity), occupancy_(occupancy),
+    calendar_(calendar)
 {}
 
 bool Link::atCapacity() {
@@ -27,39 +25,64 @@ int Link::numOverCapacity() {
 }
 
 double Link::predictedTraversalTime() {
-    // Get predicted wait time for each type of UAV
-    double predicted = 0;
-    
-    // Collect wait times on all UAVs ON the link
-    matrix1d waits;
-    for (UAV* u : traffic_) {
-        waits.push_back(u->getWait());
-    }
+    // Only the longest waits hold you up: the UAVs you don't have to wait
+    // for, and as many again ahead of you in line
+    size_t n_ok = k_capacity_ - 1;
+    size_t n_counted = std::min(traffic_.size(), 2 * n_ok);
+
+    // UAVs at the end of the link have no wait left
+    dropArrived();
+    size_t n_travelling = std::min(n_counted, exit_times_.size());
+    if (n_travelling == 0)
+        return time_;
+
+    // Sum of (exit time - now) over the latest arrivals
+    const auto &first = exit_times_[exit_times_.size() - n_travelling];
+    size_t exit_sum = exit_times_.back().second - (first.second - first.first);
+    size_t w = exit_sum - n_travelling*calendar_->now();
+
+    // Store predicted link time.
+    return time_ + static_cast<double>(w);
+}
 
-    // Sort by wait (descending)
-    sort(waits.begin(), waits.end(), greater<double>());
+void Link::dropArrived() {
+    while (!exit_times_.empty()
+        && exit_times_.front().first <= calendar_->now())
+        exit_times_.pop_front();
+}
 
-    size_t n_ok = k_capacity_ - 1;  // UAVs you don't have to wait for
-    size_t n_wait = waits.size() - n_ok;  // UAVs before you in line
-    for (int i = 0; i < (n_wait - n_ok); i++) {
-        waits.pop_back();
+size_t Link::countConflicts(size_t window) {
+    // exit_times_ is sorted, so one sweep with a trailing edge finds every
+    // UAV within window of each exit time
+    dropArrived();
+    size_t n_conflicts = 0;
+    size_t first = 0;
+    for (size_t i = 0; i < exit_times_.size(); i++) {
+        while (exit_times_[i].first - exit_times_[first].first > window)
+            first++;
+        n_conflicts += i - first;
     }
+    return n_conflicts;
+}
 
-    // Store predicted link time.
-    double w = easymath::sum(waits);
-    predicted = time_ + w;
-    if (w < 0) {
-        printf("bad");
+void Link::rebuildExitTimes() {
+    vector<size_t> exits;
+    for (UAV* u : traffic_) {
+        if (!u->atLinkEnd(calendar_->now()))
+            exits.push_back(u->getExitTime());
     }
+    std::sort(exits.begin(), exits.end());
 
-    return predicted;
+    exit_times_.clear();
+    size_t sum = 0;
+    for (size_t t : exits) {
+        sum += t;
+        exit_times_.push_back(std::make_pair(t, sum));
+    }
 }
 
 void Link::moveFrom(UAV* u, Link* l) {
-    // Add to other list (u is temporarily duplicated)
-    add(u);
-
-    // Remove from previous node (l)
+    // Remove from previous node (l) while u still holds its slot there
     try {
         l->remove(u);
     }
@@ -69,6 +92,9 @@ void Link::moveFrom(UAV* u, Link* l) {
         exit(e);
     }
 
+    // Add to this link
+    add(u);
+
     // Replan
     u->planAbstractPath();
 }
@@ -79,32 +105,47 @@ void Link::add(UAV* u) {
     if (time_ < 0) {
         printf("bad");
     }
-    u->setWait(time_);
+    size_t exit_time = calendar_->now() + time_;
+    size_t sum = exit_times_.empty() ? 0 : exit_times_.back().second;
+    exit_times_.push_back(std::make_pair(exit_time, sum + exit_time));
+    u->setExitTime(exit_time);
+    calendar_->schedule(u);
+
+    u->setLinkSlot(traffic_.size());
     traffic_.push_back(u);
+    (*occupancy_)[k_id_]++;
 }
 
 
 void Link::remove(UAV* u) {
-    try {
-        easystl::remove_element(&traffic_, u);
-    }
-    catch (int e) {
-        throw e;
-    }
+    size_t slot = u->getLinkSlot();
+    if (slot >= traffic_.size() || traffic_[slot] != u)
+        throw easystl::ELEMENT_NOT_FOUND;
+
+    // Fill the gap with the last UAV on the link
+    traffic_[slot] = traffic_.back();
+    traffic_[slot]->setLinkSlot(slot);
+    traffic_.pop_back();
+    (*occupancy_)[k_id_]--;
+
+    // UAVs normally leave once they reach the end of the link. One taken off
+    // early still has its exit time queued, so rebuild the queue without it.
+    if (!u->atLinkEnd(calendar_->now()))
+        rebuildExitTimes();
 }
 
 void Link::reset() {
-    traffic_ = list<UAV*>();
+    traffic_ = vector<UAV*>();
+    exit_times_.clear();
+    (*occupancy_)[k_id_] = 0;
 }
 
-LinkAgent::LinkAgent(size_t num_edges,
-    vector<Link*> links, size_t num_state_elements) :
+LinkAgent::LinkAgent(size_t num_edges, vector<Link*> links,
+    const LinkGraph* link_ids, const matrix1d* occupancy,
+    size_t num_state_elements) :
     k_num_edges_(num_edges),
-    IAgentBody(links.size(), num_state_elements), links_(links)
-{
-    for (size_t i = 0; i < links.size(); i++) {
-        k_link_ids_.insert(std::make_pair(std::make_pair(links[i]->k_source_, links[i]->k_target_), i));
-    }
+    IAgentBody(links.size(), num_state_elements), links_(links),
+    k_link_ids_(link_ids), k_occupancy_(occupancy) {
 }
 
 matrix1d LinkAgent::actionsToWeights(matrix2d agent_actions) {
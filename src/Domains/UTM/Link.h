@@ -2,22 +2,27 @@
 #ifndef SRC_DOMAINS_UTM_LINK_H_
 #define SRC_DOMAINS_UTM_LINK_H_
 
+#include <deque>
 #include <list>
+#include <utility>
 #include <vector>
 
 #include "IAgentBody.h"
+#include "ExitCalendar.h"
 
 class Link {
  public:
      enum {NOT_ON_LINK};  // link exceptions
      Link(size_t id, size_t source, size_t target, size_t time,
-         size_t capacity, size_t cardinal_dir);
+         size_t capacity, size_t cardinal_dir, matrix1d* occupancy,
+         ExitCalendar* calendar);
 
     //!
      bool atCapacity();
 
      int numOverCapacity();
-    std::list<UAV*> traffic_;
+    //! Unordered; each UAV records its slot so removal is a swap and pop
+    std::vector<UAV*> traffic_;
     size_t countTraffic() {
         return traffic_.size();
     }
@@ -35,6 +40,10 @@ class Link {
 
     void remove(UAV* u);
 
+    //! Number of pairs of UAVs travelling along the link whose exit times are
+    //! at most window ticks apart
+    size_t countConflicts(size_t window);
+
     const int k_source_;
     const int k_target_;
     const int k_cardinal_dir_;
@@ -45,6 +54,17 @@ class Link {
     const size_t k_id_;
     const int time_;  // Amount of time it takes to travel across link
     size_t k_capacity_;  // Capacity for each UAV type [#types]
+    matrix1d* occupancy_;  // Number of UAVs on each link, shared [linkID]
+    ExitCalendar* calendar_;  // Shared simulation clock
+
+    //! Exit times of the UAVs still travelling along the link, paired with
+    //! running sums of exit times. UAVs enter in exit time order, so the
+    //! longest waits are always at the back.
+    std::deque<std::pair<size_t, size_t> > exit_times_;
+
+    //! Drops the UAVs that have reached the end of the link
+    void dropArrived();
+    void rebuildExitTimes();
 };
 
 /**
@@ -58,8 +78,9 @@ class Link {
 class LinkAgent : public IAgentBody {
  public:
     // The agent that communicates with others
-    LinkAgent(size_t num_edges,
-        std::vector<Link*> links, size_t num_state_elements);
+    LinkAgent(size_t num_edges, std::vector<Link*> links,
+        const LinkGraph* link_ids, const matrix1d* occupancy,
+        size_t num_state_elements);
     virtual ~LinkAgent() {}
     // weights are ntypesxnagents
 
@@ -78,19 +99,24 @@ class LinkAgent : public IAgentBody {
     */
     virtual matrix1d actionsToWeights(matrix2d agent_actions);
 
+    //! Each link is its own agent
+    virtual size_t getAgent(size_t link_id) { return link_id; }
+
     std::vector<Link*> links_;
-    std::map<std::pair<size_t, size_t>, size_t> k_link_ids_;
+    //! Shared with the domain; resolves (source, target) pairs to link IDs
+    const LinkGraph* k_link_ids_;
+    const matrix1d* k_occupancy_;
 
     size_t getNthLink(UAV* u, size_t n) {
-        return k_link_ids_[u->getNthEdge(n)];
+        return k_link_ids_->get_link_id(u->getNthEdge(n));
     }
 
-    matrix2d computeCongestionState(const std::list<UAV*>& uavs) {
+    matrix2d computeCongestionState(const std::list<UAV*>&) {
         size_t num_agents = links_.size();
         matrix2d all_states = easymath::zeros(num_agents,
             1);
-        for (UAV* u : uavs)
-            all_states[getNthLink(u,0)][0]++;
+        for (size_t i = 0; i < num_agents; i++)
+            all_states[i][0] = k_occupancy_->at(i);
         agent_states_.push_back(all_states);
         return all_states;
     }
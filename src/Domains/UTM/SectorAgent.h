@@ -2,6 +2,7 @@
 #ifndef SRC_DOMAINS_UTM_SECTORAgent_H_
 #define SRC_DOMAINS_UTM_SECTORAgent_H_
 
+#include <algorithm>
 #include <map>
 #include <list>
 #include <vector>
@@ -9,42 +10,58 @@
 //! Class that manages sectors_ as agents
 class SectorAgent : public IAgentBody {
  public:
-    SectorAgent(std::vector<Link*> links,
-        std::vector<Sector*> sectors, size_t num_state_elements) :
-        IAgentBody(sectors_.size(), num_state_elements),
-        links_(links), sectors_(sectors) {
+    SectorAgent(size_t num_sectors, std::vector<Link*> links,
+        const matrix1d* occupancy, size_t num_state_elements) :
+        IAgentBody(num_sectors, num_state_elements),
+        links_(links), k_occupancy_(occupancy),
+        sector_congestion_count_(num_sectors, 0.0) {
         for (Link* l : links_) {
            k_links_toward_sector_[l->k_target_].push_back(l);
         }
+
+        // Each connection adds to the state element for its direction;
+        // with a single state element everything is summed together
+        for (Link* l : links_) {
+            size_t dir = k_num_states_ > 1 ? l->k_cardinal_dir_ : 0;
+            k_connection_dirs_.push_back(dir);
+        }
     }
     virtual ~SectorAgent() {}
 
     std::vector<Link*> links_;  // links_ in the entire system
     std::map<int, std::vector<Link*> > k_links_toward_sector_;
-    
-    matrix2d computeCongestionState(const std::list<UAV*>& uavs) {
-        size_t n_agents = sectors_.size();
-        matrix2d allStates = easymath::zeros(n_agents, k_num_states_);
-
-        for (UAV* u : uavs) {
-            std::vector<int> sector_congestion_count(n_agents, 0);
-            for (UAV* u : uavs) {
-                sector_congestion_count[u->getNthSector(0)]++;
-            }
-            for (size_t i = 0; i < sectors_.size(); i++) {
-                for (int conn : sectors_[i]->k_connections_) {
-                    easymath::XY dx =
-                        sectors_[i]->k_loc_ - sectors_[conn]->k_loc_;
-                    size_t dir = cardinal_direction(dx);
-                    allStates[i][dir]
-                        += sector_congestion_count[conn];
-                }
-            }
+    //! Shared with the domain; number of UAVs on each link [linkID]
+    const matrix1d* k_occupancy_;
+
+    /**
+    * Each sector sees the UAVs in the sectors it connects to, split by the
+    * direction of the connection. UAVs are in the source sector of the link
+    * they are on, so sector counts are summed from the link occupancy the
+    * links keep up to date, rather than recounted from the UAV list.
+    */
+    matrix2d computeCongestionState(const std::list<UAV*>&) {
+        matrix2d allStates = easymath::zeros(sector_congestion_count_.size(),
+            k_num_states_);
+
+        std::fill(sector_congestion_count_.begin(),
+            sector_congestion_count_.end(), 0.0);
+        for (size_t i = 0; i < links_.size(); i++)
+            sector_congestion_count_[links_[i]->k_source_]
+                += k_occupancy_->at(i);
+
+        for (size_t i = 0; i < links_.size(); i++) {
+            allStates[links_[i]->k_source_][k_connection_dirs_[i]]
+                += sector_congestion_count_[links_[i]->k_target_];
         }
         agent_states_.push_back(allStates);
         return allStates;
     }
 
+    //! Links are controlled by the sector they leave
+    virtual size_t getAgent(size_t link_id) {
+        return links_[link_id]->k_source_;
+    }
+
     virtual matrix1d actionsToWeights(matrix2d agent_actions) {
         // Converts format of agent output to format of A* weights
 
@@ -57,6 +74,10 @@ class SectorAgent : public IAgentBody {
         }
         return weights;
     }
-    std::vector<Sector*> sectors_;
+
+ private:
+    //! State element that each link's connection adds to [linkID]
+    std::vector<size_t> k_connection_dirs_;
+    matrix1d sector_congestion_count_;  // UAVs in each sector [sectorID]
 };
 #endif  // SRC_DOMAINS_UTM_SECTORAgent_H_
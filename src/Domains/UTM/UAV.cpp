@@ -3,6 +3,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <stdexcept>
 
 #include "UAV.h"
 #include "yaml-cpp/yaml.h"
@@ -10,10 +11,15 @@
 
 using std::list;
 
-UAV::UAV(int start_sector, int end_sector, LinkGraph* high_graph) :
-    high_graph_(high_graph), cur_sector_(start_sector), end_sector_(end_sector) {
+UAV::UAV(int start_sector, int end_sector, LinkGraph* high_graph,
+    RAGS* rags) :
+    path_pos_(0), high_graph_(high_graph), rags_(rags),
+    cur_sector_(start_sector),
+    end_sector_(end_sector), exit_time_(0), link_slot_(0) {
     YAML::Node config = YAML::LoadFile("config.yaml");
     k_search_mode_ = config["modes"]["search"].as<std::string>();
+    if (k_search_mode_ == "rags" && rags_ == NULL)
+        throw std::logic_error("UAV: \"rags\" search mode needs a planner");
 
     static int calls = 0;
     k_id_ = calls++;
@@ -31,8 +37,13 @@ void UAV::reset(int start_sector, int end_sector) {
 }
 
 void UAV::planAbstractPath() {
-    if (k_search_mode_ == "astar")
-        high_path_ = Planning::astar(high_graph_, cur_sector_, end_sector_);
+    if (k_search_mode_ == "astar") {
+        Planning::astar(high_graph_, cur_sector_, end_sector_, &high_path_);
+        path_pos_ = 0;
+    } else if (k_search_mode_ == "rags") {
+        rags_->PlanPath(&rags_cursor_, cur_sector_, end_sector_, &high_path_);
+        path_pos_ = 0;
+    }
 
 
     if (high_path_.empty()) {
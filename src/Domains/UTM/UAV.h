@@ -7,9 +7,11 @@
 #include <list>
 #include <set>
 #include <utility>
+#include <vector>
 
 // libraries includes
 #include "Planning/include/LinkGraph.h"
+#include "Planning/include/RAGS.h"
 
 class UAV {
     /*
@@ -18,34 +20,43 @@ class UAV {
     */
 public:
     typedef size_t UAVType;
-    UAV(int start_sector, int end_sector, LinkGraph* high_graph);
+    //! rags is the planner shared by all UAVs in "rags" search mode; it
+    //! must not be NULL in that mode
+    UAV(int start_sector, int end_sector, LinkGraph* high_graph,
+        RAGS* rags = NULL);
     virtual ~UAV() {};
     void reset(int start_sector, int end_sector);
     // Gets the zero-indexed nth edge in the path
     size_t getNthSector(int n) const {
-        if (high_path_.size() <= n) {
-            return high_path_.front();
+        if (high_path_.size() <= path_pos_ + n) {
+            return high_path_[path_pos_];
         }
-        return *std::next(high_path_.begin(), n);  // zero indexed
+        return high_path_[path_pos_ + n];  // zero indexed
     }
     std::pair<size_t, size_t> getNthEdge(size_t n) {
         return std::make_pair(getNthSector(n), getNthSector(n + 1));
     }
     void incrementPath() {
-        high_path_.pop_front();
-        cur_sector_ = high_path_.front();
+        cur_sector_ = high_path_[++path_pos_];
     }
 
     virtual void planAbstractPath();
-    bool atLinkEnd() const { return t_ <= 0; }
-    bool atTerminalLink() const { return high_path_.size() <= 2; }
-    int getWait() const { return t_; }
-    void setWait(int time) { t_ = time; }
-    void decrementWait() { t_--; }
+    bool atLinkEnd(size_t now) const { return exit_time_ <= now; }
+    bool atTerminalLink() const { return high_path_.size() - path_pos_ <= 2; }
+    //! Ticks left before reaching the end of the current link
+    size_t getWait(size_t now) const {
+        return atLinkEnd(now) ? 0 : exit_time_ - now;
+    }
+    size_t getExitTime() const { return exit_time_; }
+    void setExitTime(size_t time) { exit_time_ = time; }
     void setCurSector(size_t s) {
         cur_sector_ = s;
     }
     size_t getId() const { return k_id_; }
+
+    //! Position of this UAV in its current link's traffic
+    size_t getLinkSlot() const { return link_slot_; }
+    void setLinkSlot(size_t slot) { link_slot_ = slot; }
 private:
 
 
@@ -55,8 +66,13 @@ private:
     }
 
     std::string k_search_mode_;
-    std::list<size_t> high_path_;
+    //! Planned sectors; high_path_[path_pos_] is the current sector. The
+    //! storage is reused between replans, so advancing does not allocate.
+    std::vector<size_t> high_path_;
+    size_t path_pos_;
     LinkGraph* high_graph_;
+    RAGS* rags_;
+    RAGS::Cursor rags_cursor_;  // this UAV's place in rags_'s path sets
     size_t cur_sector_, next_sector_, end_sector_;
     std::list<size_t> getBestPath() const {
         return Planning::astar<LinkGraph, size_t>
@@ -69,7 +85,8 @@ private:
     // Typedefs
     typedef std::pair<size_t, size_t> edge;
 
-    int t_;
+    size_t exit_time_;  // Tick at which the UAV reaches the end of its link
+    size_t link_slot_;
     size_t next_sector_id_;  // This gets updated after UAV moves
     size_t cur_sector_id_;   // for debugging
 };
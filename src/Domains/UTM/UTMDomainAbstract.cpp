@@ -1,10 +1,16 @@
 // Copyright 2016 Carrie Rebhuhn
 #include "UTMDomainAbstract.h"
 
+#include <algorithm>
+#include <functional>
 #include <string>
 #include <map>
 #include <iostream>
 #include <list>
+#include <queue>
+#include <set>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include "FileIO/include/FileOut.h"
@@ -17,9 +23,7 @@ using std::string;
 using std::list;
 using std::vector;
 using std::map;
-using std::bind;
 using std::to_string;
-using std::placeholders::_1;
 using easyio::file_exists;
 using easyio::read_pairs;
 using easyio::read2;
@@ -33,6 +37,10 @@ UTMDomainAbstract::UTMDomainAbstract(string config_file, bool) :
 
     // Load the configurations
     YAML::Node configs = YAML::LoadFile(config_file);
+    if (configs["constants"]["seed"])
+        easymath::seed(configs["constants"]["seed"].as<uint64_t>());
+
+    k_reward_mode_ = configs["modes"]["reward"].as<string>();
 
     string domain_dir = UTMFileNames::createDomainDirectory(configs);
     string efile = domain_dir + "edges.csv";
@@ -53,9 +61,18 @@ UTMDomainAbstract::UTMDomainAbstract(string config_file, bool) :
 
     high_graph_ = new LinkGraph(locs, edges);
 
+    rags_ = NULL;
+    if (configs["modes"]["search"].as<string>() == "rags") {
+        vector<RAGS::edge> rags_edges;
+        for (edge e : edges)
+            rags_edges.push_back(RAGS::edge(static_cast<int>(e.first),
+                static_cast<int>(e.second)));
+        rags_ = new RAGS(locs, rags_edges);
+        rags_->UpdateEdgeCosts(high_graph_->get_weights());
+    }
+
     // Link construction
     double flat_capacity = configs["constants"]["capacity"].as<double>();
-    k_link_ids_ = new map<edge, size_t>();
     for (edge e : edges) addLink(e, flat_capacity);
 
     k_agent_mode_ = configs["modes"]["agent"].as<string>();
@@ -65,33 +82,41 @@ UTMDomainAbstract::UTMDomainAbstract(string config_file, bool) :
         k_num_states_ = 4;
     }
     if (k_agent_mode_ == "sector") {
-        agents_ = new SectorAgent(links_, sectors_, k_num_states_);
-        k_num_agents_ = sectors_.size();
+        agents_ = new SectorAgent(k_num_sectors_, links_, &link_occupancy_,
+            k_num_states_);
+        k_num_agents_ = k_num_sectors_;
     } else {
-        agents_ = new LinkAgent(links_.size(), links_, k_num_states_);
+        agents_ = new LinkAgent(links_.size(), links_, high_graph_,
+            &link_occupancy_, k_num_states_);
         k_num_agents_ = links_.size();
     }
     num_uavs_at_sector_ = zeros(k_num_sectors_);
 
     k_objective_mode_ = configs["modes"]["objective"].as<string>();
-    k_reward_mode_ = configs["modes"]["reward"].as<string>();
+    // In ticks; the detail domain's conflict_thresh is a distance
+    if (configs["constants"]["conflict_ticks"])
+        k_conflict_ticks_ =
+            configs["constants"]["conflict_ticks"].as<size_t>();
+    else
+        k_conflict_ticks_ = 0;
 }
 
 void UTMDomainAbstract::addLink(UTMDomainAbstract::edge e,
     double flat_capacity) {
     size_t source = e.first;   // membership of origin of edge
     size_t target = e.second;  // membership of connected node
-    vector<XY> locs = high_graph_->get_locations();
-    XY s_loc = locs[source];
-    XY t_loc = locs[target];
-    size_t cardinal_dir = cardinal_direction(s_loc - t_loc);
-    size_t dist = static_cast<size_t>(euclidean_distance(s_loc, t_loc));
+
+    // Links are added in the order of the graph's edges
+    size_t id = links_.size();
+    size_t cardinal_dir = high_graph_->get_link_direction(id);
+    size_t dist = static_cast<size_t>(high_graph_->get_link_length(id));
     if (dist == 0)
         dist = 1;
+    link_occupancy_.push_back(0);
     links_.push_back(
-        new Link(links_.size(), source, target, dist,
-            static_cast<size_t>(flat_capacity), cardinal_dir));
-    k_link_ids_->insert(make_pair(e, links_.size() - 1));
+        new Link(id, source, target, dist,
+            static_cast<size_t>(flat_capacity), cardinal_dir,
+            &link_occupancy_, &calendar_));
 
     k_incoming_links_[target].push_back(source);
 }
@@ -104,17 +129,24 @@ void UTMDomainAbstract::generateNewAirspace(string domain_dir, size_t xdim,
 
 UTMDomainAbstract::UTMDomainAbstract(string config_file) :
     UTMDomainAbstract(config_file, true) {
+    // Difference rewards are only implemented for the detail domain
+    if (k_reward_mode_ != "global" && k_reward_mode_ != "local") {
+        throw std::invalid_argument("Unsupported reward mode \""
+            + k_reward_mode_ + "\": the abstract domain supports global "
+            "and local rewards");
+    }
+
     // Sector/Fix  construction
-    vector<edge> edges = high_graph_->get_edges();
+    const vector<edge> &edges = high_graph_->get_edges();
     vector<vector<size_t> > connections(k_num_sectors_);
     for (edge e : edges)
         connections[e.first].push_back(e.second);
 
-    vector<XY> sector_locs = high_graph_->get_locations();
+    const vector<XY> &sector_locs = high_graph_->get_locations();
     for (size_t i = 0; i < k_num_sectors_; i++) {
         Sector* s = new Sector(sector_locs[i], i, connections[i], sector_locs);
         s->generation_pt_ = new Fix(s->k_loc_, s->k_id_, high_graph_,
-            sector_locs);
+            sector_locs, rags_);
         sectors_.push_back(s);
     }
 
@@ -130,7 +162,6 @@ UTMDomainAbstract::UTMDomainAbstract(string config_file) :
 }
 
 UTMDomainAbstract::~UTMDomainAbstract(void) {
-    delete k_link_ids_;
     delete agents_;
 
     for (Link* l : links_) delete l;
@@ -139,62 +170,138 @@ UTMDomainAbstract::~UTMDomainAbstract(void) {
     for (size_t s = 0; s < sectors_.size(); s++)
         for (UAV* ud : uavs_done_[s])
             delete ud;
+    delete rags_;
 }
 
 matrix1d UTMDomainAbstract::getPerformance() {
-    // TODO
-    exit(1);
-    return matrix1d();
+    // G is the negative of the episode's total cost
+    if (k_objective_mode_ == "conflict")
+        return matrix1d(1, -agents_->total_conflicts_);
+    else if (agents_->k_square_reward_mode_)
+        return matrix1d(1, -agents_->total_squared_delay_);
+    else
+        return matrix1d(1, -agents_->total_delay_);
 }
 
 matrix1d UTMDomainAbstract::getRewards() {
-    // TODO
-    exit(1);
-    return matrix1d();
+    if (k_reward_mode_ == "global")
+        return matrix1d(k_num_agents_, getPerformance()[0]);
+
+    // Local: each agent is rewarded with its own share of the cost
+    const matrix1d *cost;
+    if (k_objective_mode_ == "conflict")
+        cost = &agents_->conflicts_;
+    else if (agents_->k_square_reward_mode_)
+        cost = &agents_->squared_delays_;
+    else
+        cost = &agents_->delays_;
+
+    matrix1d R(cost->size());
+    for (size_t i = 0; i < R.size(); i++)
+        R[i] = -cost->at(i);
+    return R;
 }
 
 
 void UTMDomainAbstract::incrementUavPath() {
-    vector<UAV*> eligible;              // uavs_ eligible to move to next link
-    copy_if(uavs_.begin(), uavs_.end(), back_inserter(eligible), [](UAV* u) {
-        if (u->atLinkEnd()) {
-            if (u->atTerminalLink()) {
-                return false;
-            } else {
-                return true;
-            }
-        } else {
-            u->decrementWait();
-            return false;
-        }
-    });
-
-    if (eligible.empty()) {
-        return;
-    } else {
+    // uavs_ eligible to move to next link: those at the end of their link,
+    // unless it is the last link of their path
+    vector<UAV*> eligible;
+    copy_if(uavs_at_link_end_.begin(), uavs_at_link_end_.end(),
+        back_inserter(eligible),
+        [](UAV* u) { return !u->atTerminalLink(); });
+
+    // All other uavs_ move one tick along their link
+    vector<UAV*> arrived = calendar_.advance();
+    size_t n_waiting = uavs_at_link_end_.size();
+    uavs_at_link_end_.insert(uavs_at_link_end_.end(), arrived.begin(),
+        arrived.end());
+    std::inplace_merge(uavs_at_link_end_.begin(),
+        uavs_at_link_end_.begin() + n_waiting, uavs_at_link_end_.end(),
+        [](UAV* a, UAV* b) { return a->getId() < b->getId(); });
+
+    if (!eligible.empty()) {
         // This moves all uavs_ that are eligible and not blocked
         tryToMove(&eligible);
         // Only those that cannot move are left in eligible
         // printf("%i uavs_ delayed. \n",eligible.size());
 
+        // Delay is charged to the agent of the full link each UAV waits on
+        vector<size_t> delayed_agents;
         for (UAV* u : eligible) {
-            // TODO delay added here to reward
+            delayed_agents.push_back(agents_->getAgent(getNthLink(u, 1)));
 
             // Add 1 to the sector that the UAV is trying to move from
             num_uavs_at_sector_[u->getNthSector(1)]++;
         }
+        agents_->addDelays(delayed_agents);
+
+        // Those that moved are on a new link
+        size_t now = calendar_.now();
+        remove_erase_if(&uavs_at_link_end_,
+            [now](UAV* u) { return !u->atLinkEnd(now); });
     }
 }
 
 void UTMDomainAbstract::tryToMove(vector<UAV*> * eligible_to_move) {
-    random_shuffle(eligible_to_move->begin(), eligible_to_move->end());
-
-    size_t el_size;
-    do {
-        el_size = eligible_to_move->size();
-        remove_erase_if(eligible_to_move,
-            bind(uavReadyToMove, links_, k_link_ids_, _1));
-    } while (el_size != eligible_to_move->size());
+    easymath::shuffle(eligible_to_move->begin(), eligible_to_move->end(),
+        easymath::RNG_SCHEDULE);
+
+    /**
+    * Same outcome as sweeping the shuffled list over and over, moving every
+    * UAV whose next link has room, until a sweep moves nobody. Each UAV is
+    * visited once at (sweep 0, rank). A UAV blocked by a full link is only
+    * visited again when a UAV leaves that link, at the point where the
+    * sweep would next have reached it.
+    */
+    vector<UAV*> &order = *eligible_to_move;
+    typedef std::pair<size_t, size_t> visit;  // (sweep, rank)
+    std::priority_queue<visit, vector<visit>, std::greater<visit> > visits;
+    vector<size_t> cur(order.size()), next(order.size());
+    for (size_t r = 0; r < order.size(); r++) {
+        if (order[r]->atTerminalLink())
+            continue;
+        cur[r] = getNthLink(order[r], 0);
+        next[r] = getNthLink(order[r], 1);
+        visits.push(visit(0, r));
+    }
+
+    map<size_t, std::set<size_t> > blocked;  // ranks waiting on each link
+    vector<bool> moved(order.size(), false);
+    while (!visits.empty()) {
+        visit v = visits.top();
+        visits.pop();
+        size_t r = v.second;
+        if (links_[next[r]]->atCapacity()) {
+            blocked[next[r]].insert(r);
+            continue;
+        }
+
+        order[r]->incrementPath();
+        links_[next[r]]->moveFrom(order[r], links_[cur[r]]);
+        moved[r] = true;
+
+        // The space left behind goes to the next UAV the sweep reaches
+        auto waiting = blocked.find(cur[r]);
+        if (waiting == blocked.end() || waiting->second.empty())
+            continue;
+        size_t sweep = v.first;
+        auto w = waiting->second.upper_bound(r);
+        if (w == waiting->second.end()) {
+            w = waiting->second.begin();
+            sweep++;
+        }
+        visits.push(visit(sweep, *w));
+        waiting->second.erase(w);
+    }
+
+    // Only those that cannot move are left, in shuffled order
+    size_t n_left = 0;
+    for (size_t r = 0; r < order.size(); r++) {
+        if (!moved[r])
+            order[n_left++] = order[r];
+    }
+    order.resize(n_left);
 }
 
 matrix2d UTMDomainAbstract::getStates() {
@@ -213,6 +320,8 @@ void UTMDomainAbstract::simulateStep(matrix2d agent_actions) {
         matrix1d w = agents_->actionsToWeights(agent_actions);
         high_graph_->set_weights(w);
     }
+    if (rags_)
+        rags_->UpdateEdgeCosts(high_graph_->get_weights());
 
     // Note: this adds to traffic
     this->getNewUavTraffic();
@@ -230,50 +339,35 @@ void UTMDomainAbstract::simulateStep(matrix2d agent_actions) {
         detectConflicts();
 }
 
-// Records information about a single step in the domain
+// Ends a step: only the per-step sector counts are kept, not a history
 void UTMDomainAbstract::logStep() {
-    if (k_agent_mode_ == "sector" || k_agent_mode_ == "link") {
-        matrix1d num_uavs_on_links(links_.size(), 0);
-        for (size_t i = 0; i < links_.size(); i++) {
-            num_uavs_on_links[i] = links_[i]->traffic_.size();
-        }
-        link_uavs_.push_back(num_uavs_on_links);
-
-        sector_uavs_.push_back(num_uavs_at_sector_);
+    if (k_agent_mode_ == "sector" || k_agent_mode_ == "link")
         num_uavs_at_sector_ = zeros(sectors_.size());
-    }
-}
-
-bool UTMDomainAbstract::uavReadyToMove(vector<Link*> L,
-    map<edge, size_t> *L_IDs, UAV *u) {
-    size_t n, c;
-    n = L_IDs->at(u->getNthEdge(1));  // Next link ID
-    c = L_IDs->at(u->getNthEdge(0));  // Cur link ID
-
-    if (u->atTerminalLink())
-        return false;
-    if (L[n]->atCapacity())
-        return false;
-    u->incrementPath();
-    L[n]->moveFrom(u, L[c]);
-    return true;
 }
 
 void UTMDomainAbstract::exportSectorLocations(int fileID) {
     vector<easymath::XY> sectorLocations;
     for (Sector* s : sectors_)
         sectorLocations.push_back(s->k_loc_);
-    FileOut::print_pair_container(sectorLocations,
+    FileOut::print_xy_container(sectorLocations,
         "visualization/agent_locations" + to_string(fileID) + ".csv");
 }
 
 void UTMDomainAbstract::detectConflicts() {
-    // TODO
+    // Two UAVs conflict when they are on the same link and within
+    // k_conflict_ticks_ ticks of each other
+    for (size_t i = 0; i < links_.size(); i++) {
+        if (link_occupancy_[i] < 2)
+            continue;
+        size_t n = links_[i]->countConflicts(k_conflict_ticks_);
+        if (n > 0)
+            agents_->addConflicts(i, n);
+    }
 }
 
 void UTMDomainAbstract::getPathPlans() {
     for (UAV* u : uavs_) {
-        if (!u->atLinkEnd())
+        if (!u->atLinkEnd(calendar_.now()))
             u->planAbstractPath();
     }
 }
@@ -297,6 +391,8 @@ void UTMDomainAbstract::reset() {
     for (Link* l : links_) {
         l->reset();
     }
+    calendar_.reset();
+    uavs_at_link_end_.clear();
     (*cur_step_) = 0;
     agents_->reset();
 
@@ -309,29 +405,46 @@ void UTMDomainAbstract::reset() {
 }
 
 void UTMDomainAbstract::absorbUavTraffic() {
-    for (auto u : uavs_) {
-        auto cur_link = k_link_ids_->at(u->getNthEdge(0));
-        if (u->atLinkEnd() && u->atTerminalLink()) {
-            if (k_disposal_mode_ == "keep") {
-                auto cur_sector = u->getNthSector(1);
-                u->setCurSector(cur_sector);
-                sectors_.at(cur_sector)->generation_pt_->resetUav(u);
-                auto new_cur_link = getNthLink(u, 0);
-                links_[new_cur_link]->moveFrom(u, links_[cur_link]);
-            } else {
-                // Remove
-                links_.at(cur_link)->remove(u);
-                delete u;
-                u = NULL;
-            }
+    // Only uavs_ at the end of their link can reach their destination
+    vector<UAV*> absorbed;
+    for (UAV* u : uavs_at_link_end_) {
+        if (!u->atTerminalLink())
+            continue;
+
+        auto cur_link = high_graph_->get_link_id(u->getNthEdge(0));
+        if (k_disposal_mode_ == "keep") {
+            auto cur_sector = u->getNthSector(1);
+            u->setCurSector(cur_sector);
+            sectors_.at(cur_sector)->generation_pt_->resetUav(u);
+            auto new_cur_link = getNthLink(u, 0);
+            links_[new_cur_link]->moveFrom(u, links_[cur_link]);
+        } else {
+            // Remove
+            links_.at(cur_link)->remove(u);
+            absorbed.push_back(u);
         }
     }
-    remove_erase_if(&uavs_, [](UAV* u) { return u == NULL; });
+
+    if (!absorbed.empty()) {
+        std::sort(absorbed.begin(), absorbed.end());
+        auto is_absorbed = [&absorbed](UAV* u) {
+            return std::binary_search(absorbed.begin(), absorbed.end(), u);
+        };
+        remove_erase_if(&uavs_, is_absorbed);
+        remove_erase_if(&uavs_at_link_end_, is_absorbed);
+        for (UAV* u : absorbed)
+            delete u;
+    }
+
+    // uavs_ that were kept have started a new link
+    size_t now = calendar_.now();
+    remove_erase_if(&uavs_at_link_end_,
+        [now](UAV* u) { return !u->atLinkEnd(now); });
 }
 
 void UTMDomainAbstract::getNewUavTraffic(int s) {
     UAV* u = sectors_.at(s)->generation_pt_->generateUav();
-    auto cur_link = k_link_ids_->at(u->getNthEdge(0));
+    auto cur_link = high_graph_->get_link_id(u->getNthEdge(0));
     links_.at(cur_link)->add(u);
     uavs_.push_back(u);
 }
@@ -342,14 +455,14 @@ void UTMDomainAbstract::getNewUavTraffic() {
         UAV* u = sectors_.at(s)->generation_pt_->generateUav(*cur_step_);
         if (u == NULL) return;
 
-        auto cur_link = k_link_ids_->at(u->getNthEdge(0));
+        auto cur_link = high_graph_->get_link_id(u->getNthEdge(0));
         links_.at(cur_link)->add(u);
         uavs_.push_back(u);
     }
 }
 
 size_t UTMDomainAbstract::getNthLink(UAV* u, size_t n) {
-    return k_link_ids_->at(u->getNthEdge(n));
+    return high_graph_->get_link_id(u->getNthEdge(n));
 }
 
 string UTMDomainAbstract::createExperimentDirectory(string config_file) {
@@ -12,6 +12,7 @@
 #include "IAgentBody.h"
 #include "Planning/include/LinkGraph.h"
 #include "Link.h"
+#include "ExitCalendar.h"
 #include "Sector.h"
 
 class UTMFileNames {
@@ -74,22 +75,25 @@ class UTMDomainAbstract : public IDomainStateful {
     IAgentBody* agents_;
     size_t k_num_sectors_;
     LinkGraph *high_graph_;
-    std::map<edge, size_t> *k_link_ids_;
+    //! Planner shared by all UAVs in "rags" search mode, otherwise NULL
+    RAGS *rags_;
     std::vector<Link*> links_;
+    matrix1d link_occupancy_;  // The number of UAVs on each link [linkID]
     std::string k_reward_mode_;
     matrix1d num_uavs_at_sector_;
     std::string k_objective_mode_, k_agent_mode_, k_disposal_mode_;
+    //! Ticks apart along a link at which UAVs are still in conflict
+    size_t k_conflict_ticks_;
     std::vector<Sector*> sectors_;
-    matrix2d link_uavs_;    // The number of UAVs on each link, [step][linkID]
-    matrix2d sector_uavs_;  // The number of UAVs waiting at a sector,
-                           // [step][sectorID]
     std::list<UAV*> uavs_;
+    ExitCalendar calendar_;  // Schedules uavs_ reaching the end of a link
+    //! uavs_ that have reached the end of their link, in the same (ID) order
+    //! as uavs_
+    std::vector<UAV*> uavs_at_link_end_;
     std::map<int, std::list<UAV*> > uavs_done_;
     std::map<int, std::list<int> > k_incoming_links_;
 
     void simulateStep(matrix2d agent_actions);
-    static bool uavReadyToMove(std::vector<Link*> L,
-        std::map<edge, size_t> *L_IDs, UAV *u);
     void generateNewAirspace(std::string dir, size_t xdim, size_t ydim);
     void addLink(edge e, double flat_capacity);
     std::string createExperimentDirectory(std::string config_file);
@@ -128,6 +128,26 @@ public:
             FileErrors::failed_file(file_name);
     }
 
+    //! Print-to-file for a 1D container of points with x and y members,
+    //! in the same format as print_pair_container.
+    template<class T>
+    static void print_xy_container(const T &data, std::string file_name, bool overwrite = true, std::string separator = ",") {
+        std::ofstream file;
+        if (overwrite) file.open(file_name.c_str(), std::ofstream::out | std::ofstream::trunc);
+        else file.open(file_name.c_str(), std::ofstream::out | std::ofstream::app);
+
+        if (!overwrite) file << '\n';
+
+        if (file.is_open()) {
+            for (const auto &it : data) {
+                file << it.x << separator << it.y << separator << "\n";
+            }
+            file.close();
+            printf("... Successfully wrote to file %s.\n", file_name.c_str());
+        } else
+            FileErrors::failed_file(file_name);
+    }
+
 private:
     //! Helper function for 1- and 2-d file output
     template <class T>
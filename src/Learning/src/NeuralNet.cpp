@@ -2,7 +2,6 @@
 #include "NeuralNet.h"
 #include <vector>
 #include <string>
-#include <ctime>
 
 using easymath::rand;
 using easymath::sum;
@@ -22,7 +21,7 @@ NeuralNet::Layer::Layer(size_t above, size_t below) :
 }
 
 double NeuralNet::randSetFanIn(double fan_in) {
-    return rand(-10, 10) / sqrt(fan_in);
+    return rand(-10, 10, easymath::RNG_LEARNING) / sqrt(fan_in);
 }
 
 void NeuralNet::mutate() {
@@ -40,14 +39,11 @@ void NeuralNet::mutate() {
 double NeuralNet::randAddFanIn(double fan_in, double mut_rate, double mut_std) {
     // Adds random amount mutRate_% of the time,
     // amount based on fan_in and mut_std
-    if (rand(0, 1) > mut_rate) {
+    if (rand(0, 1, easymath::RNG_LEARNING) > mut_rate) {
         return 0.0;
     } else {
-        std::default_random_engine generator;
-        generator.seed(static_cast<size_t>(time(NULL)));
-        std::normal_distribution<double> distribution(0.0, mut_std);
         // Note: divide by fan_in later
-        return distribution(generator);
+        return easymath::rand_normal(0.0, mut_std, easymath::RNG_LEARNING);
     }
 }
 
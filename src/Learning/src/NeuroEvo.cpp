@@ -76,7 +76,7 @@ double NeuroEvo::getBestMemberVal() {
 
 void random_shuffle(list<NeuralNet*> *L) {
     vector<NeuralNet*> tmp(L->begin(), L->end());
-    random_shuffle(tmp.begin(), tmp.end());
+    easymath::shuffle(tmp.begin(), tmp.end(), easymath::RNG_LEARNING);
     copy(tmp.begin(), tmp.end(), L->begin());
 }
 
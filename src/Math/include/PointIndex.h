@@ -0,0 +1,52 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef MATH_POINTINDEX_H_
+#define MATH_POINTINDEX_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "XY.h"
+
+namespace easymath {
+/**
+* Looks up a fixed set of points by their coordinates. Exact matches go
+* through a hash map. Nearest-point queries search a uniform grid of buckets
+* outward from the query's cell, so only nearby points are compared.
+*/
+class PointIndex {
+ public:
+    //! Returned when no point matches
+    static const size_t npos = static_cast<size_t>(-1);
+
+    PointIndex() : cell_size_(1.0), nx_(0), ny_(0) {}
+    //! Indexes points by position in the vector. If a location appears
+    //! more than once, the last index is kept.
+    explicit PointIndex(const std::vector<XY> &points);
+
+    size_t size() const { return points_.size(); }
+    const XY& at(size_t i) const { return points_.at(i); }
+
+    //! Index of the point equal to p, or npos if there is none
+    size_t find(const XY &p) const {
+        auto found = exact_.find(p);
+        return found == exact_.end() ? npos : found->second;
+    }
+
+    //! Index of the point nearest to p (euclidean), or npos if empty
+    size_t nearest(const XY &p) const;
+
+ private:
+    std::vector<XY> points_;
+    std::unordered_map<XY, size_t> exact_;
+
+    // Buckets of point indices, [x + nx_*y]
+    double cell_size_;
+    XY origin_;
+    size_t nx_, ny_;
+    std::vector<std::vector<size_t> > cells_;
+
+    size_t cell_x(double x) const;
+    size_t cell_y(double y) const;
+};
+}  // namespace easymath
+#endif  // MATH_POINTINDEX_H_
@@ -0,0 +1,61 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef MATH_RANDOM_H_
+#define MATH_RANDOM_H_
+
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+
+namespace easymath {
+/**
+* Random numbers for the whole library come from one seed, split into an
+* independent stream per component. Draws in one component never shift the
+* sequence seen by another, so e.g. adding a mutation to the learner leaves
+* the traffic unchanged. The engines and the conversions below are fully
+* specified, so a seed replays a run bit for bit on the same platform.
+*/
+enum rng_stream {
+    RNG_DEFAULT,   // anything not listed below
+    RNG_GRAPH,     // airspace generation
+    RNG_TRAFFIC,   // UAV generation and destinations
+    RNG_SCHEDULE,  // order in which UAVs are moved
+    RNG_LEARNING,  // policy initialization, mutation and selection
+    RNG_STREAMS
+};
+
+typedef std::mt19937_64 rng_engine;
+
+//! Seed used until seed() is called
+static const uint64_t k_default_seed = 1;
+
+//! Restarts every stream from seed
+void seed(uint64_t s);
+
+//! Seed of the current streams
+uint64_t get_seed();
+
+//! The engine behind a stream, for use with <random> distributions
+rng_engine& rng(rng_stream s = RNG_DEFAULT);
+
+//! Returns a random number in [low, high)
+double rand(double low, double high, rng_stream s = RNG_DEFAULT);
+
+//! Returns a uniformly random index in [0, n). n must be positive.
+size_t rand_index(size_t n, rng_stream s = RNG_DEFAULT);
+
+//! Returns a normally distributed random number
+double rand_normal(double mean, double std_dev, rng_stream s = RNG_DEFAULT);
+
+//! Shuffles [first, last) uniformly (Fisher-Yates). Unlike std::shuffle
+//! the order produced for a seed does not depend on the standard library.
+template <class RandomIt>
+void shuffle(RandomIt first, RandomIt last, rng_stream s = RNG_DEFAULT) {
+    size_t n = static_cast<size_t>(std::distance(first, last));
+    for (size_t i = n; i > 1; i--) {
+        using std::swap;
+        swap(first[i - 1], first[rand_index(i, s)]);
+    }
+}
+}  // namespace easymath
+#endif  // MATH_RANDOM_H_
@@ -0,0 +1,106 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef MATH_SPATIALHASH_H_
+#define MATH_SPATIALHASH_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "XY.h"
+
+namespace easymath {
+/**
+* Uniform grid over the plane that buckets points into square cells. With
+* the cell size set to a distance threshold, any two points within that
+* distance of each other lie in the same or neighbouring cells, so pairs can
+* be found without comparing every point against every other.
+*/
+class SpatialHash {
+ public:
+    //! A cell size that is not positive buckets points by their exact
+    //! coordinates, so only coincident points are paired
+    explicit SpatialHash(double cell_size) : cell_size_(cell_size),
+        exact_(!(cell_size > 0)) {}
+
+    //! Removes all points
+    void clear();
+
+    //! Adds a point and returns its index (the number of earlier inserts)
+    size_t insert(const XY &p);
+
+    size_t size() const { return points_.size(); }
+
+    //! Calls f(i, j) once for each pair of points no more than dist apart.
+    //! dist must not exceed the cell size.
+    template <class F>
+    void for_each_pair_within(double dist, F f) const;
+
+ private:
+    typedef std::pair<int64_t, int64_t> cell;
+    struct cell_hash {
+        size_t operator()(const cell &c) const {
+            uint64_t x = static_cast<uint64_t>(c.first);
+            uint64_t y = static_cast<uint64_t>(c.second);
+            return std::hash<uint64_t>()(x * 73856093 ^ y);
+        }
+    };
+
+    double cell_size_;
+    bool exact_;
+    std::vector<XY> points_;
+    std::unordered_map<cell, std::vector<size_t>, cell_hash> cells_;
+
+    cell get_cell(const XY &p) const {
+        return cell(get_coordinate(p.x), get_coordinate(p.y));
+    }
+
+    //! Cell index along one axis. Indices beyond +-2^62 are clamped, which
+    //! only merges distant cells.
+    int64_t get_coordinate(double q) const {
+        if (exact_) {
+            if (q == 0.0) q = 0.0;  // -0.0 shares a cell with 0.0
+            int64_t bits;
+            std::memcpy(&bits, &q, sizeof(bits));
+            return bits;
+        }
+        const double limit = 4611686018427387904.0;
+        double c = std::floor(q / cell_size_);
+        if (!(c > -limit)) return static_cast<int64_t>(-limit);
+        if (!(c < limit)) return static_cast<int64_t>(limit);
+        return static_cast<int64_t>(c);
+    }
+};
+
+template <class F>
+void SpatialHash::for_each_pair_within(double dist, F f) const {
+    double d2 = dist*dist;
+    auto within = [&](size_t i, size_t j) {
+        double dx = points_[i].x - points_[j].x;
+        double dy = points_[i].y - points_[j].y;
+        return dx*dx + dy*dy <= d2;
+    };
+
+    // Each neighbouring pair of cells is visited from one side only
+    const int64_t offsets[4][2] = { { 1, 0 }, { -1, 1 }, { 0, 1 }, { 1, 1 } };
+    for (const auto &c : cells_) {
+        const std::vector<size_t> &here = c.second;
+        for (size_t a = 0; a < here.size(); a++)
+            for (size_t b = a + 1; b < here.size(); b++)
+                if (within(here[a], here[b])) f(here[a], here[b]);
+
+        for (const auto &o : offsets) {
+            auto n = cells_.find(cell(c.first.first + o[0],
+                c.first.second + o[1]));
+            if (n == cells_.end()) continue;
+            for (size_t i : here)
+                for (size_t j : n->second)
+                    if (within(i, j)) f(i, j);
+        }
+    }
+}
+}  // namespace easymath
+#endif  // MATH_SPATIALHASH_H_
@@ -1,16 +1,17 @@
 // Copyright 2016 Carrie Rebhuhn
 #ifndef MATH_XY_H_
 #define MATH_XY_H_
-#include <utility>
+#include <cstring>
+#include <functional>
 
 namespace easymath {
 //! A class for locations. Contains many overloads for vector arithmetic.
-class XY : public std::pair<double, double> {
+//! Just the two coordinates, so it can be copied as plain memory.
+class XY {
  public:
-    XY(const double &x, const double &y) :
-        pair<double, double>(x, y), x(x), y(y) {}
+    XY(const double &x, const double &y) : x(x), y(y) {}
 
-    XY() {};
+    XY() = default;
 
     double x, y;
 
@@ -27,8 +28,11 @@ class XY : public std::pair<double, double> {
 
     //! Checks equality of both elements
     bool operator==(const XY &rhs) const {
-        return x == rhs.x && y == rhs.y &&
-            first == rhs.first && second == rhs.second;
+        return x == rhs.x && y == rhs.y;
+    }
+
+    bool operator!=(const XY &rhs) const {
+        return !(*this == rhs);
     }
 
     //! Scalar multiplication
@@ -45,15 +49,32 @@ class XY : public std::pair<double, double> {
     XY operator+(const XY &rhs) const {
         return XY(x + rhs.x, y + rhs.y);
     }
+};
+
+static_assert(sizeof(XY) == 2*sizeof(double), "XY must hold only x and y");
+
+//! Hash for unordered containers of XY. Points that compare equal hash
+//! equally, including 0.0 and -0.0.
+struct XY_hash {
+    size_t operator()(const XY &p) const {
+        return combine(bits(p.x), bits(p.y));
+    }
 
-    //! Assignment operator
-    XY& operator=(const XY &rhs) {
-        x = rhs.x;
-        y = rhs.y;
-        first = rhs.first;
-        second = rhs.second;
-        return *this;
+ private:
+    static size_t bits(double d) {
+        if (d == 0.0) d = 0.0;
+        unsigned long long b;
+        std::memcpy(&b, &d, sizeof(b));
+        return std::hash<unsigned long long>()(b);
+    }
+    static size_t combine(size_t a, size_t b) {
+        return a ^ (b + 0x9e3779b9 + (a << 6) + (a >> 2));
     }
 };
 }  // namespace easymath
+
+namespace std {
+template <>
+struct hash<easymath::XY> : public easymath::XY_hash {};
+}  // namespace std
 #endif  // MATH_XY_H_
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "MatrixTypes.h"
+#include "Random.h"
 #include "XY.h"
 
 namespace easymath {
@@ -33,9 +34,6 @@ double cross(const XY &U, const XY &V);
 //! Coinciding endpoints excluded). Returns true if so.
 bool intersects_in_center(line_segment edge1, line_segment edge2);
 
-//! Returns a random number between some bounds.
-double rand(double low, double high);
-
 //! Error function (this exists in linux but not windows)
 double erfc(double x);
 
@@ -59,5 +57,51 @@ std::vector<std::pair<size_t, size_t> > all_combos_of_2(size_t n);
 
 bool is_endpt(const XY& a, const line_segment& b);
 bool pt_on_line(const XY& a, const line_segment& b, const double thresh = 0.01);
+
+//! Many points stored as one array per coordinate (structure of arrays), so
+//! that tests over all of them can be vectorized
+struct xy_buffer {
+    std::vector<double> x, y;
+
+    void push_back(const XY &p) {
+        x.push_back(p.x);
+        y.push_back(p.y);
+    }
+    size_t size() const { return x.size(); }
+    void clear() {
+        x.clear();
+        y.clear();
+    }
+};
+
+//! Many line segments, as buffers of their first and second endpoints
+struct segment_buffer {
+    xy_buffer first, second;
+
+    void push_back(const line_segment &l) {
+        first.push_back(l.first);
+        second.push_back(l.second);
+    }
+    size_t size() const { return first.size(); }
+    void clear() {
+        first.clear();
+        second.clear();
+    }
+};
+
+//! Batch intersects_in_center: sets (*mask)[i] to 1 if segments[i]
+//! intersects edge in the center, else 0
+void intersects_in_center(const segment_buffer &segments,
+    const line_segment &edge, std::vector<char> *mask);
+
+//! Index of the first of segments that intersects edge in the center, or
+//! segments.size() if none do
+size_t first_intersecting_in_center(const segment_buffer &segments,
+    const line_segment &edge);
+
+//! Index of the first of pts that is on l (as pt_on_line) without being
+//! one of its endpoints (as is_endpt), or pts.size() if there is none
+size_t first_pt_on_line(const xy_buffer &pts, const line_segment &l,
+    const double thresh = 0.01);
 }  // namespace easymath
 #endif  // MATH_EASYMATH_H_
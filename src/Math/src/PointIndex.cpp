@@ -0,0 +1,87 @@
+// Copyright 2016 Carrie Rebhuhn
+#include "PointIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace easymath {
+const size_t PointIndex::npos;
+
+PointIndex::PointIndex(const std::vector<XY> &points) : points_(points),
+    cell_size_(1.0), nx_(0), ny_(0) {
+    if (points_.empty())
+        return;
+
+    for (size_t i = 0; i < points_.size(); i++)
+        exact_[points_[i]] = i;
+
+    // Cells sized so that each holds about one point on average
+    XY lo = points_[0], hi = points_[0];
+    for (const XY &p : points_) {
+        lo = XY(std::min(lo.x, p.x), std::min(lo.y, p.y));
+        hi = XY(std::max(hi.x, p.x), std::max(hi.y, p.y));
+    }
+    double w = hi.x - lo.x, h = hi.y - lo.y;
+    double n = static_cast<double>(points_.size());
+    if (w > 0 && h > 0)
+        cell_size_ = std::sqrt(w*h / n);
+    else if (w + h > 0)
+        cell_size_ = (w + h) / n;
+
+    origin_ = lo;
+    nx_ = static_cast<size_t>(w / cell_size_) + 1;
+    ny_ = static_cast<size_t>(h / cell_size_) + 1;
+    cells_.assign(nx_*ny_, std::vector<size_t>());
+    for (size_t i = 0; i < points_.size(); i++)
+        cells_[cell_x(points_[i].x) + nx_*cell_y(points_[i].y)].push_back(i);
+}
+
+size_t PointIndex::cell_x(double x) const {
+    double c = std::floor((x - origin_.x) / cell_size_);
+    if (!(c > 0)) return 0;
+    return std::min(static_cast<size_t>(c), nx_ - 1);
+}
+
+size_t PointIndex::cell_y(double y) const {
+    double c = std::floor((y - origin_.y) / cell_size_);
+    if (!(c > 0)) return 0;
+    return std::min(static_cast<size_t>(c), ny_ - 1);
+}
+
+size_t PointIndex::nearest(const XY &p) const {
+    if (points_.empty())
+        return npos;
+
+    // Search rings of cells around p's cell. Cells in ring r are at least
+    // (r - 1) cells from p, so stop once the best point is closer than that.
+    long cx = static_cast<long>(cell_x(p.x));
+    long cy = static_cast<long>(cell_y(p.y));
+    long max_ring = static_cast<long>(std::max(nx_, ny_));
+    size_t best = npos;
+    double best_d2 = std::numeric_limits<double>::infinity();
+    for (long r = 0; r <= max_ring; r++) {
+        double reach = (r - 1)*cell_size_;
+        if (r > 0 && reach*reach > best_d2)
+            break;
+
+        for (long y = cy - r; y <= cy + r; y++) {
+            if (y < 0 || y >= static_cast<long>(ny_)) continue;
+            // Only the edge of the ring is new; interior rows skip ahead
+            long step = (y == cy - r || y == cy + r) ? 1 : std::max(2*r, 1L);
+            for (long x = cx - r; x <= cx + r; x += step) {
+                if (x < 0 || x >= static_cast<long>(nx_)) continue;
+                for (size_t i : cells_[x + nx_*y]) {
+                    double dx = points_[i].x - p.x, dy = points_[i].y - p.y;
+                    double d2 = dx*dx + dy*dy;
+                    if (d2 < best_d2 || (d2 == best_d2 && i < best)) {
+                        best_d2 = d2;
+                        best = i;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+}  // namespace easymath
@@ -0,0 +1,71 @@
+// Copyright 2016 Carrie Rebhuhn
+#include "Random.h"
+
+#include <cmath>
+
+namespace easymath {
+namespace {
+struct streams {
+    streams() { reseed(k_default_seed); }
+
+    void reseed(uint64_t s) {
+        seed = s;
+        for (uint32_t i = 0; i < RNG_STREAMS; i++) {
+            std::seed_seq seq = { static_cast<uint32_t>(s),
+                static_cast<uint32_t>(s >> 32), i };
+            engines[i].seed(seq);
+        }
+    }
+
+    uint64_t seed;
+    rng_engine engines[RNG_STREAMS];
+};
+
+streams& get_streams() {
+    static streams all;
+    return all;
+}
+
+//! 53 random bits as a double in [0, 1)
+double unit(rng_engine* g) {
+    return static_cast<double>((*g)() >> 11) / 9007199254740992.0;
+}
+}  // namespace
+
+void seed(uint64_t s) {
+    get_streams().reseed(s);
+}
+
+uint64_t get_seed() {
+    return get_streams().seed;
+}
+
+rng_engine& rng(rng_stream s) {
+    return get_streams().engines[s];
+}
+
+double rand(double low, double high, rng_stream s) {
+    return unit(&rng(s))*(high - low) + low;
+}
+
+size_t rand_index(size_t n, rng_stream s) {
+    // Reject the low 2^64 mod n values so every remainder is equally likely
+    rng_engine &g = rng(s);
+    uint64_t range = static_cast<uint64_t>(n);
+    uint64_t threshold = (0 - range) % range;
+    uint64_t x;
+    do {
+        x = g();
+    } while (x < threshold);
+    return static_cast<size_t>(x % range);
+}
+
+double rand_normal(double mean, double std_dev, rng_stream s) {
+    // Box-Muller; 1 - u keeps the log argument in (0, 1]
+    rng_engine &g = rng(s);
+    double u1 = 1.0 - unit(&g);
+    double u2 = unit(&g);
+    const double two_pi = 6.283185307179586;
+    return mean + std_dev*std::sqrt(-2.0*std::log(u1))*std::cos(two_pi*u2);
+}
+}  // namespace easymath
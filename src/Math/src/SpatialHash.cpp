@@ -0,0 +1,15 @@
+// Copyright 2016 Carrie Rebhuhn
+#include "SpatialHash.h"
+
+namespace easymath {
+void SpatialHash::clear() {
+    points_.clear();
+    cells_.clear();
+}
+
+size_t SpatialHash::insert(const XY &p) {
+    cells_[get_cell(p)].push_back(points_.size());
+    points_.push_back(p);
+    return points_.size() - 1;
+}
+}  // namespace easymath
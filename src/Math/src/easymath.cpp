@@ -5,12 +5,19 @@
 #include <utility>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EASYMATH_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace easymath {
 std::set<XY> get_n_unique_points(double x_min, double x_max,
     double y_min, double y_max, size_t n) {
     std::set<XY> pt_set;
     while (pt_set.size() < n) {
-        XY p = XY(rand(x_min, x_max), rand(y_min, y_max));
+        XY p = XY(rand(x_min, x_max, RNG_GRAPH),
+            rand(y_min, y_max, RNG_GRAPH));
         pt_set.insert(p);
     }
     return pt_set;
@@ -36,7 +43,7 @@ std::vector<subscript> get_n_unique_square_subscripts(size_t n) {
 
     size_t n_surplus = square - n;
     for (size_t i = 0; i < n_surplus; i++) {
-        int randn = std::rand() % static_cast<int>(inds.size());
+        size_t randn = rand_index(inds.size(), RNG_GRAPH);
         inds.erase(inds.begin()+randn);
     }
 
@@ -97,11 +104,6 @@ size_t bin(const double &n, const matrix1d& bounds) {
     return bounds.size();
 }
 
-double rand(double low, double high) {
-    double r = static_cast<double>(std::rand()) / static_cast<double>(RAND_MAX);
-    return r*(high - low) + low;
-}
-
 double cross(const XY &U, const XY &V) {
     return U.x*V.y - U.y*V.x;
 }
@@ -208,4 +210,143 @@ bool pt_on_line(const XY &p, const line_segment &l, const double threshold) {
         return (abv_xmin && blw_xmax && abv_ymin && blw_ymax);
     }
 }
+
+/**
+* The batch tests below compute exactly what their single versions do, two
+* elements at a time with SSE2 where it is available. The scalar loops
+* handle the remainder and other targets; they have no branches, so the
+* compiler may vectorize them too. The masks are doubles (1 or 0), the same
+* width as the coordinates. Tests that stop at the first hit work through
+* the buffer a block at a time.
+*/
+static const size_t k_batch_block = 64;
+
+// Sets mask[i - begin] to intersects_in_center(segments[i], edge)
+static void intersects_in_center_block(const segment_buffer &segments,
+    const line_segment &edge, size_t begin, size_t end, double *mask) {
+    const double *px = &segments.first.x[begin];
+    const double *py = &segments.first.y[begin];
+    const double *ex = &segments.second.x[begin];
+    const double *ey = &segments.second.y[begin];
+    double qx = edge.first.x, qy = edge.first.y;
+    double sx = edge.second.x - qx, sy = edge.second.y - qy;
+
+    size_t i = 0;
+#ifdef EASYMATH_SSE2
+    const __m128d zero = _mm_setzero_pd(), one = _mm_set1_pd(1.0);
+    const __m128d vqx = _mm_set1_pd(qx), vqy = _mm_set1_pd(qy);
+    const __m128d vsx = _mm_set1_pd(sx), vsy = _mm_set1_pd(sy);
+    for (; i + 2 <= end - begin; i += 2) {
+        __m128d vpx = _mm_loadu_pd(px + i), vpy = _mm_loadu_pd(py + i);
+        __m128d rx = _mm_sub_pd(_mm_loadu_pd(ex + i), vpx);
+        __m128d ry = _mm_sub_pd(_mm_loadu_pd(ey + i), vpy);
+        __m128d dx = _mm_sub_pd(vqx, vpx);
+        __m128d dy = _mm_sub_pd(vqy, vpy);
+        __m128d rscross = _mm_sub_pd(_mm_mul_pd(rx, vsy), _mm_mul_pd(ry, vsx));
+        __m128d t = _mm_div_pd(
+            _mm_sub_pd(_mm_mul_pd(dx, vsy), _mm_mul_pd(dy, vsx)), rscross);
+        __m128d u = _mm_div_pd(
+            _mm_sub_pd(_mm_mul_pd(dx, ry), _mm_mul_pd(dy, rx)), rscross);
+        __m128d in = _mm_and_pd(
+            _mm_and_pd(_mm_cmplt_pd(zero, t), _mm_cmplt_pd(t, one)),
+            _mm_and_pd(_mm_cmplt_pd(zero, u), _mm_cmplt_pd(u, one)));
+        _mm_storeu_pd(mask + i, _mm_and_pd(in, one));
+    }
+#endif
+    for (; i < end - begin; i++) {
+        double rx = ex[i] - px[i];
+        double ry = ey[i] - py[i];
+        double dx = qx - px[i];
+        double dy = qy - py[i];
+        double rscross = rx*sy - ry*sx;
+        double t = (dx*sy - dy*sx) / rscross;
+        double u = (dx*ry - dy*rx) / rscross;
+        // Parallel segments divide by zero, which fails every comparison
+        mask[i] = ((0 < t) & (t < 1) & (0 < u) & (u < 1)) ? 1.0 : 0.0;
+    }
+}
+
+// Sets mask[i - begin] if pts[i] is on l but not an endpoint of it
+static void pt_on_line_block(const xy_buffer &pts, const line_segment &l,
+    double thresh, size_t begin, size_t end, double *mask) {
+    const double *x = &pts.x[begin], *y = &pts.y[begin];
+    double x1 = l.first.x, y1 = l.first.y, x2 = l.second.x, y2 = l.second.y;
+    double m = (y2 - y1) / (x2 - x1);
+    double b = y1 - x1*m;
+    double x_min = std::min(x1, x2), x_max = std::max(x1, x2);
+    double y_min = std::min(y1, y2), y_max = std::max(y1, y2);
+
+    size_t i = 0;
+#ifdef EASYMATH_SSE2
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d abs_mask = _mm_castsi128_pd(
+        _mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d vm = _mm_set1_pd(m), vb = _mm_set1_pd(b);
+    const __m128d vthresh = _mm_set1_pd(thresh);
+    const __m128d vx1 = _mm_set1_pd(x1), vy1 = _mm_set1_pd(y1);
+    const __m128d vx2 = _mm_set1_pd(x2), vy2 = _mm_set1_pd(y2);
+    const __m128d vx_min = _mm_set1_pd(x_min), vx_max = _mm_set1_pd(x_max);
+    const __m128d vy_min = _mm_set1_pd(y_min), vy_max = _mm_set1_pd(y_max);
+    for (; i + 2 <= end - begin; i += 2) {
+        __m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i);
+        __m128d y_on_line = _mm_add_pd(_mm_mul_pd(vm, vx), vb);
+        __m128d diff = _mm_and_pd(_mm_sub_pd(vy, y_on_line), abs_mask);
+        __m128d on_line = _mm_cmpngt_pd(diff, vthresh);
+        __m128d in_box = _mm_and_pd(
+            _mm_and_pd(_mm_cmpge_pd(vx, vx_min), _mm_cmple_pd(vx, vx_max)),
+            _mm_and_pd(_mm_cmpge_pd(vy, vy_min), _mm_cmple_pd(vy, vy_max)));
+        __m128d endpt = _mm_or_pd(
+            _mm_and_pd(_mm_cmpeq_pd(vx, vx1), _mm_cmpeq_pd(vy, vy1)),
+            _mm_and_pd(_mm_cmpeq_pd(vx, vx2), _mm_cmpeq_pd(vy, vy2)));
+        __m128d hit = _mm_andnot_pd(endpt, _mm_and_pd(on_line, in_box));
+        _mm_storeu_pd(mask + i, _mm_and_pd(hit, one));
+    }
+#endif
+    for (; i < end - begin; i++) {
+        double y_on_line = m*x[i] + b;
+        double diff = fabs(y[i] - y_on_line);
+        bool on_line = !(diff > thresh);
+        bool in_box = (x[i] >= x_min) & (x[i] <= x_max)
+            & (y[i] >= y_min) & (y[i] <= y_max);
+        bool endpt = ((x[i] == x1) & (y[i] == y1))
+            | ((x[i] == x2) & (y[i] == y2));
+        mask[i] = (on_line & in_box & !endpt) ? 1.0 : 0.0;
+    }
+}
+
+void intersects_in_center(const segment_buffer &segments,
+    const line_segment &edge, std::vector<char> *mask) {
+    mask->resize(segments.size());
+    double block[k_batch_block];
+    for (size_t begin = 0; begin < segments.size(); begin += k_batch_block) {
+        size_t end = std::min(begin + k_batch_block, segments.size());
+        intersects_in_center_block(segments, edge, begin, end, block);
+        for (size_t i = begin; i < end; i++)
+            (*mask)[i] = block[i - begin] != 0.0;
+    }
+}
+
+size_t first_intersecting_in_center(const segment_buffer &segments,
+    const line_segment &edge) {
+    double block[k_batch_block];
+    for (size_t begin = 0; begin < segments.size(); begin += k_batch_block) {
+        size_t end = std::min(begin + k_batch_block, segments.size());
+        intersects_in_center_block(segments, edge, begin, end, block);
+        for (size_t i = begin; i < end; i++)
+            if (block[i - begin] != 0.0) return i;
+    }
+    return segments.size();
+}
+
+size_t first_pt_on_line(const xy_buffer &pts, const line_segment &l,
+    const double thresh) {
+    double block[k_batch_block];
+    for (size_t begin = 0; begin < pts.size(); begin += k_batch_block) {
+        size_t end = std::min(begin + k_batch_block, pts.size());
+        pt_on_line_block(pts, l, thresh, begin, end, block);
+        for (size_t i = begin; i < end; i++)
+            if (block[i - begin] != 0.0) return i;
+    }
+    return pts.size();
+}
 }  // namespace easymath
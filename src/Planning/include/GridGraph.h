@@ -4,6 +4,7 @@
 
 
 // from boost
+#include <boost/dynamic_bitset.hpp>
 #include <boost/graph/filtered_graph.hpp>
 #include <boost/graph/grid_graph.hpp>
 #include <boost/unordered_map.hpp>
@@ -49,6 +50,23 @@ struct vertex_equal {
 };
 
 
+//! Packed occupancy grid: bit (x + y*x_dim) is set if cell (x,y) is blocked.
+typedef boost::dynamic_bitset<> barrier_bitset;
+
+//! Vertex filter that tests passability against the active barrier bitset.
+//! Holds a pointer to the owner's active-mask pointer, so that swapping
+//! masks does not require rebuilding the filtered graph.
+struct barrier_filter {
+    barrier_filter() : mask(NULL), x_dim(0) {}
+    barrier_filter(const barrier_bitset* const* mask_set, size_t x_dim_set) :
+        mask(mask_set), x_dim(x_dim_set) {}
+    bool operator()(const grid::vertex_descriptor &v) const {
+        return !(**mask)[v[0] + v[1] * x_dim];
+    }
+    const barrier_bitset* const* mask;
+    size_t x_dim;
+};
+
 typedef IBoostGraph<grid, easymath::XY, vertex_hash, vertex_equal> GridBase;
 
 class GridGraph : public GridBase {
@@ -63,8 +81,8 @@ class GridGraph : public GridBase {
     }
 
 
-    typedef boost::unordered_set<vertex_descriptor, vertex_hash, vertex_equal> vertex_set;
-    typedef boost::vertex_subset_complement_filter<grid, vertex_set>::type filtered_grid;
+    typedef boost::filtered_graph<grid, boost::keep_all, barrier_filter>
+        filtered_grid;
 
     vertex_descriptor get_descriptor(easymath::XY pt) {
         return{ static_cast<size_t>(pt.x), static_cast<size_t>(pt.y) };
@@ -76,6 +94,7 @@ class GridGraph : public GridBase {
     double get_y(vertex_descriptor v) { return static_cast<double>(v[1]); }
 
     typedef std::pair<size_t, size_t> edge;
+    typedef std::pair<int, int> sector_pair;
     typedef std::vector<std::vector<bool> > barrier_grid;
 
 
@@ -91,8 +110,20 @@ class GridGraph : public GridBase {
     //! Filter the barrier vertices out of the underlying grid.
     filtered_grid create_barrier_grid();
 
-    //! The barriers in the AStarGrid
-    vertex_set m_barriers;
+    size_t m_x_dim, m_y_dim;
+
+    //! Cells that are never passable (negative membership)
+    barrier_bitset m_obstacles;
+
+    //! Cells belonging to each sector, [membership]
+    std::vector<barrier_bitset> m_sector_cells;
+
+    //! Cached occlusion masks, keyed by (lower, higher) membership
+    boost::unordered_map<sector_pair, barrier_bitset> m_occlusion_masks;
+
+    //! The barriers in the AStarGrid. Points at m_obstacles or at one of the
+    //! cached occlusion masks.
+    const barrier_bitset* m_barriers;
 
     grid m_grid;
 
@@ -101,17 +132,34 @@ class GridGraph : public GridBase {
     filtered_grid g;
 
     GridGraph() : GridGraph(easymath::zeros(1, 1)) {}
+    GridGraph(const GridGraph &other);
 
     explicit GridGraph(const matrix2d &members);
     virtual ~GridGraph() {}
 
-    //! Adds barriers if a cell does not match membership m1 or m2
+    //! Adds barriers if a cell does not match membership m1 or m2.
+    //! Replaces any previous occlusion; the mask is built once per pair.
     void occlude_nonmembers(int m1, int m2);
 
+    //! Removes sector occlusion, leaving only the obstacles.
+    void clear_occlusion() { m_barriers = &m_obstacles; }
+
+    //! Builds the occlusion masks for the given sector pairs up front
+    void precompute_occlusion_masks(const std::vector<edge> &sector_pairs);
+
+    //! Returns (building if needed) the barrier mask for a sector pair
+    const barrier_bitset& get_occlusion_mask(int m1, int m2);
+
     // Accessor functions
     const int get_membership(easymath::XY p) {
         return static_cast<int>(
             members[static_cast<size_t>(p.x)][static_cast<size_t>(p.y)]);
     }
+    bool is_barrier(size_t x, size_t y) const {
+        return (*m_barriers)[x + y*m_x_dim];
+    }
+
+ private:
+    void set_sector_cells();
 };
 #endif  // PLANNING_GRIDGRAPH_H_
@@ -0,0 +1,68 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef PLANNING_HIERARCHICALGRAPH_H_
+#define PLANNING_HIERARCHICALGRAPH_H_
+
+// STL includes
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+// library includes
+#include "Math/include/easymath.h"
+#include "GridGraph.h"
+
+/**
+* Hierarchical path abstraction (HPA*) over a GridGraph whose cells are
+* labelled by sector membership. Sector borders are reduced to one transition
+* per adjacent sector pair, and optimal intra-sector paths between those
+* transitions are cached. Detailed legs from one border to the next come from
+* the cache, so a change in sector-level weights only requires replanning on
+* the abstract (LinkGraph) level.
+*/
+class HierarchicalGraph {
+ public:
+    typedef std::pair<size_t, size_t> edge;
+    typedef std::list<easymath::XY> grid_path;
+
+    //! A border crossing: last cell in the source sector, first in the target
+    struct transition {
+        easymath::XY exit, entry;
+    };
+
+    //! Finds the border transitions between the sectors in sector_edges and
+    //! caches the intra-sector paths that connect them.
+    HierarchicalGraph(GridGraph* low_graph,
+        const std::vector<edge> &sector_edges);
+    ~HierarchicalGraph() {}
+
+    bool has_transition(size_t from, size_t to) const {
+        return transitions_.count(edge(from, to)) > 0;
+    }
+    const transition& get_transition(size_t from, size_t to) const {
+        return transitions_.at(edge(from, to));
+    }
+
+    //! Detailed path from start (in sector cur) to the first cell of next.
+    //! Returns an empty path if the sectors do not share a border. Only legs
+    //! that start at a transition come from the cache.
+    grid_path get_leg(easymath::XY start, size_t cur, size_t next);
+
+    //! Number of cached intra-sector paths
+    size_t get_n_cached() const { return intra_paths_.size(); }
+
+ private:
+    GridGraph* low_graph_;
+    std::map<edge, transition> transitions_;
+    std::map<std::pair<easymath::XY, easymath::XY>, grid_path> intra_paths_;
+
+    void findTransitions();
+    void cacheIntraPaths(const std::vector<edge> &sector_edges);
+
+    //! Optimal path between two cells of the same sector
+    grid_path findIntraPath(easymath::XY from, easymath::XY to);
+
+    //! As findIntraPath, cached; only used between transitions
+    const grid_path& getIntraPath(easymath::XY from, easymath::XY to);
+};
+#endif  // PLANNING_HIERARCHICALGRAPH_H_
@@ -11,9 +11,11 @@
 #include <utility>
 #include <string>
 #include <map>
+#include <stdexcept>
 
 // library includes
 #include "Math/include/easymath.h"
+#include "Math/include/PointIndex.h"
 #include "FileIO/include/FileOut.h"
 #include "Planning.h"
 
@@ -47,10 +49,8 @@ class LinkGraph : public LinkBase {
 
     double get_path_cost(std::list<vertex_descriptor> p) {
         double c = 0;
-        for (auto v = p.begin(); std::next(v) != p.end(); v++) {
-            auto e = boost::edge(*v, *std::next(v),g).first;
-            c += get(boost::edge_weight, g, e);
-        }
+        for (auto v = p.begin(); std::next(v) != p.end(); v++)
+            c += m_weights[get_link_id(*v, *std::next(v))];
         return c;
     }
     double get_y(vertex_descriptor v) { return locations[v].y; }
@@ -59,7 +59,7 @@ class LinkGraph : public LinkBase {
 
     matrix1d saved_weights;  // for blocking and unblocking sectors
     std::vector<easymath::XY> locations;
-    std::map<easymath::XY, size_t> loc2mem;  // maps location to membership
+    easymath::PointIndex loc2mem;  // maps location to membership
 
     void blockVertex(int vertexID);
     void unblockVertex();
@@ -67,6 +67,7 @@ class LinkGraph : public LinkBase {
     bool intersects_existing_edge(edge candidate);
 
 
+    //! Boost view of the graph, kept in sync with the CSR arrays for search
     mygraph_t g;
     LinkGraph(const LinkGraph& other) :
         LinkGraph(other.get_locations(), other.get_edges()) {}
@@ -80,17 +81,79 @@ class LinkGraph : public LinkBase {
 
     //! Accessor functions
     size_t get_n_vertices() const { return locations.size(); }
-    size_t get_n_edges() const { return num_edges(g); }
+    size_t get_n_edges() const { return m_edges.size(); }
     easymath::XY get_vertex_loc(size_t vID) const { return locations.at(vID); }
-    size_t get_membership(easymath::XY pt) const { return loc2mem.at(pt); }
-    matrix1d get_weights() const;
-    std::vector<edge> get_edges() const;
-    std::vector<easymath::XY> get_locations() const { return locations; }
-    void set_weights(matrix1d weights);
+    //! Vertex at exactly pt; throws std::out_of_range if there is none
+    size_t get_membership(easymath::XY pt) const {
+        size_t v = loc2mem.find(pt);
+        if (v == easymath::PointIndex::npos)
+            throw std::out_of_range("LinkGraph: no vertex at location");
+        return v;
+    }
+    //! Vertex closest to pt
+    size_t get_nearest_vertex(easymath::XY pt) const {
+        return loc2mem.nearest(pt);
+    }
+    matrix1d get_weights() const { return m_weights; }
+    const std::vector<edge>& get_edges() const { return m_edges; }
+    const std::vector<easymath::XY>& get_locations() const {
+        return locations;
+    }
+    void set_weights(const matrix1d &weights);
+
+    //! Link IDs follow the order of the edge array the graph was built from
+    double get_weight(size_t link) const { return m_weights[link]; }
+    edge get_edge(size_t link) const { return m_edges[link]; }
+    //! Euclidean length of a link, from source to target location
+    double get_link_length(size_t link) const { return m_lengths[link]; }
+    //! Cardinal direction of a link, as cardinal_direction(source - target)
+    size_t get_link_direction(size_t link) const { return m_directions[link]; }
+    size_t get_link_id(size_t source, size_t target) const;
+    size_t get_link_id(const edge &e) const {
+        return get_link_id(e.first, e.second);
+    }
 
     size_t get_direction(size_t m1, size_t m2) const;
 
     //! Printout
     void print_graph(std::string file_path);
+
+ private:
+    //! Per-link arrays, indexed by link ID
+    std::vector<edge> m_edges;
+    matrix1d m_weights;
+    std::vector<mygraph_t::edge_descriptor> m_descriptors;
+    matrix1d m_lengths;
+    std::vector<size_t> m_directions;
+    //! Link and vertex coordinates, batched for intersects_existing_edge
+    easymath::segment_buffer m_segments;
+    easymath::xy_buffer m_points;
+
+    //! Compressed sparse rows: the out-links of vertex v occupy
+    //! [m_row_offsets[v], m_row_offsets[v+1]), sorted by target
+    std::vector<size_t> m_row_offsets;
+    std::vector<size_t> m_col_targets;
+    std::vector<size_t> m_col_links;
+
+    //! Graphs with at most this many vertices also get a dense V x V table
+    //! of link IDs, so link lookup is a single index
+    static const size_t k_max_dense_vertices = 128;
+    static const size_t k_no_link = static_cast<size_t>(-1);
+    std::vector<size_t> m_link_table;
+
+    //! Generated graphs with more vertices than this only consider pairs of
+    //! vertices within k_candidate_radius mean spacings of each other
+    static const size_t k_max_all_pairs_vertices = 1000;
+    static const double k_candidate_radius;
+
+    //! Adds each candidate, in order, that crosses no edge added so far and
+    //! passes through no other vertex (as intersects_existing_edge)
+    void add_planar_edges(const std::vector<edge> &candidates,
+        double cell_size);
+
+    //! Builds the CSR arrays and boost view from an edge array
+    void set_edges(const std::vector<edge> &edge_array);
+    //! Link ID from source to target, or k_no_link
+    size_t find_link(size_t source, size_t target) const;
 };
 #endif  // PLANNING_LINKGRAPH_H_
@@ -0,0 +1,63 @@
+// Copyright 2016 Carrie Rebhuhn
+#ifndef PLANNING_NODEARENA_H_
+#define PLANNING_NODEARENA_H_
+
+// STL includes
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+* Bump allocator for search nodes. Nodes are constructed in fixed-size blocks
+* so their addresses stay valid as the arena grows, and each has an index in
+* creation order. reset() discards every node at once and keeps the blocks for
+* the next search, so node types must not need destruction.
+*/
+template <class T>
+class NodeArena {
+ public:
+    static_assert(std::is_trivially_destructible<T>::value,
+        "NodeArena never runs destructors");
+    static const size_t k_block_size = 4096;
+
+    NodeArena() : n_used_(0) {}
+    ~NodeArena() {
+        for (T* b : blocks_)
+            ::operator delete(b);
+    }
+
+    //! Constructs a node from args at the next free slot
+    template <class... Args>
+    T* create(Args&&... args) {
+        size_t b = n_used_ / k_block_size;
+        if (b == blocks_.size())
+            blocks_.push_back(static_cast<T*>(
+                ::operator new(sizeof(T)*k_block_size)));
+        T* slot = blocks_[b] + n_used_ % k_block_size;
+        n_used_++;
+        return new (slot) T(std::forward<Args>(args)...);
+    }
+
+    //! Node created index-th since the last reset
+    T& operator[](size_t index) {
+        return blocks_[index / k_block_size][index % k_block_size];
+    }
+
+    //! Number of nodes created since the last reset
+    size_t size() const { return n_used_; }
+
+    //! Discards all nodes; their memory is reused by later calls to create
+    void reset() { n_used_ = 0; }
+
+ private:
+    std::vector<T*> blocks_;
+    size_t n_used_;
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+};
+
+template <class T>
+const size_t NodeArena<T>::k_block_size;
+#endif  // PLANNING_NODEARENA_H_
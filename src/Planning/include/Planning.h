@@ -67,36 +67,49 @@ auto get_params(G* GraphWrapper, const Gbase&, const V& goal) {
         .visitor(detail::astar_goal_visitor<V>(goal));
 }
 
-}  // namespace detail
-
-template <class G, class V>
-std::list<V> astar(G* g, V start, V goal) {
+//! Searches from start to goal, writing the path into solution (which is
+//! cleared first). Returns false if the goal is unreachable.
+template <class G, class V, class Path>
+bool astar_into(G* g, V start, V goal, Path* solution) {
     auto s = g->get_descriptor(start);
     auto e = g->get_descriptor(goal);
-    auto h = detail::get_euclidean_heuristic(g, g->g, e);
+    auto h = get_euclidean_heuristic(g, g->g, e);
 
     // initializes and resets the predecessor maps
     g->init_pmaps();
 
-    auto gv = Planning::detail::astar_goal_visitor<typename G::vertex_descriptor>(e);
+    auto gv = astar_goal_visitor<typename G::vertex_descriptor>(e);
     auto p = boost::weight_map(g->weight).predecessor_map(g->pred_pmap).distance_map(g->dist_pmap).visitor(gv);
 
-    std::list<V> solution;
+    solution->clear();
     try {
         boost::astar_search(g->g, s, h, p);
     }
-    catch (detail::found_goal) {
+    catch (found_goal) {
         for (auto u = e; ; u = g->pred_pmap[u]) {
             V val = g->get_vertex_base(u);
-            solution.push_back(val);
+            solution->push_back(val);
             if (u == g->pred_pmap[u])
                 break;
         }
-        std::reverse(solution.begin(), solution.end());
-        return solution;
+        std::reverse(solution->begin(), solution->end());
+        return true;
     }
+    return false;
+}
+}  // namespace detail
 
+template <class G, class V>
+std::list<V> astar(G* g, V start, V goal) {
+    std::list<V> solution;
+    detail::astar_into(g, start, goal, &solution);
     return solution;
 }
+
+//! As above, but reuses the storage of an existing path
+template <class G, class V>
+void astar(G* g, V start, V goal, std::vector<V>* solution) {
+    detail::astar_into(g, start, goal, solution);
+}
 }  // namespace Planning
 #endif  // PLANNING_PLANNING_H_
@@ -17,14 +17,18 @@
 #include <numeric>
 #include <queue>
 #include <vector>
+#include <map>
 
 #include "Math/include/easymath.h"
+#include "Math/include/PointIndex.h"
+#include "NodeArena.h"
 
 typedef unsigned long ULONG;
 enum searchType { ASTAR, DIJKSTRA };  // BREADTH, DEPTH
 enum heuristic { ZERO, MANHATTAN, EUCLIDEAN };
 enum pathOut { BEST, ALL };
 enum nodeType { SOURCE, OTHER };
+enum quadrature { TABULATED, ADAPTIVE };
 
 const double pi = 3.14159265358979323846264338328;
 
@@ -37,10 +41,12 @@ const double pi = 3.14159265358979323846264338328;
 class Node;
 class Vertex {
  public:
-    Vertex(double x, double y) :
-        itsX(x), itsY(y) {}
+    Vertex(double x, double y, ULONG id = 0) :
+        itsX(x), itsY(y), itsID(id), itsCTC(0.0) {}
     ~Vertex() {}
 
+    //! Position in the graph's vertex array
+    ULONG GetID() const { return itsID; }
     double GetX() const { return itsX; }
     void SetX(double x) { itsX = x; }
     double GetY() const { return itsY; }
@@ -60,6 +66,7 @@ class Vertex {
     double itsActualCost;
     double itsX;
     double itsY;
+    ULONG itsID;
     double itsCTC;
     std::vector<Node *> itsNodes;
 };
@@ -104,11 +111,13 @@ class Graph {
         const std::vector<edge> &edge_array, const matrix2d &weights) {
         itsVertices = GenerateVertices(locations);
         itsEdges = GenerateEdges(edge_array, weights);
+        GenerateAdjacency(edge_array);
     }
     Graph(const std::vector<easymath::XY> &locations,
         const std::vector<edge> &edge_array) {
         itsVertices = GenerateVertices(locations);
         itsEdges = GenerateEdges(edge_array);
+        GenerateAdjacency(edge_array);
     }
 
     ~Graph() {
@@ -131,6 +140,16 @@ class Graph {
     ULONG GetNumVertices() const { return numVertices; }
     ULONG GetNumEdges() const { return numEdges; }
 
+    //! Index of the vertex at exactly v, or PointIndex::npos
+    size_t FindVertexIndex(const easymath::XY &v) const {
+        return itsLocationIndex.find(v);
+    }
+    //! Vertex at exactly v, or NULL if there is none
+    Vertex * FindVertex(const easymath::XY &v) const {
+        size_t i = FindVertexIndex(v);
+        return i == easymath::PointIndex::npos ? NULL : itsVertices[i];
+    }
+
     std::vector<Edge *> GetNeighbours(easymath::XY v);
     std::vector<Edge *> GetNeighbours(Vertex * v);
     std::vector<Edge *> GetNeighbours(const easymath::XY &v,
@@ -143,11 +162,18 @@ class Graph {
     Edge ** itsEdges;
     ULONG numVertices;
     ULONG numEdges;
+    easymath::PointIndex itsLocationIndex;
+
+    // Out-edges of vertex i are itsOutEdges[itsOutStart[i]] up to
+    // itsOutEdges[itsOutStart[i+1]], in edge array order
+    std::vector<ULONG> itsOutStart;
+    std::vector<Edge *> itsOutEdges;
 
     Vertex ** GenerateVertices(const std::vector<easymath::XY> &vertices);
     Edge ** GenerateEdges(const std::vector<edge> &edges,
         const matrix2d &weights);
     Edge ** GenerateEdges(const std::vector<edge> &edges);
+    void GenerateAdjacency(const std::vector<edge> &edges);
 };
 
 // Node class to maintain path information up to a vertex
@@ -155,11 +181,12 @@ class Graph {
 class Node {
  public:
     explicit Node(Vertex * vertex) :
-        itsVertex(vertex), itsParent(0), itsMeanCost(0.0), itsVarCost(0.0),
-        itsDepth(0), itsHeuristic(0.0), itsMeanCTG(0.0), itsVarCTG(0.0) {}
+        itsVertex(vertex), itsParent(0), itsAncestors(0), itsMeanCost(0.0),
+        itsVarCost(0.0), itsDepth(0), itsHeuristic(0.0), itsMeanCTG(0.0),
+        itsVarCTG(0.0) {}
 
     Node(Vertex * vertex, nodeType n) :
-        itsVertex(vertex), itsParent(0), itsHeuristic(0.0) {
+        itsVertex(vertex), itsParent(0), itsAncestors(0), itsHeuristic(0.0) {
         switch (n) {
         case SOURCE:
             itsMeanCost = 0.0;
@@ -179,15 +206,17 @@ class Node {
     Node(Node * parent, Edge * edge) :
         itsParent(parent), itsHeuristic(0.0), itsMeanCTG(0.0), itsVarCTG(0.0) {
         itsVertex = edge->GetVertex2();
+        itsAncestors = AncestorsOf(parent);
         itsMeanCost = itsParent->GetMeanCost() + edge->GetMeanSearch();
         itsVarCost = itsParent->GetVarCost() + edge->GetVarSearch();
         itsDepth = itsParent->GetDepth() + 1;
     }
 
-    ~Node() {}
-
     Node * GetParent() const { return itsParent; }
-    void SetParent(Node * parent) { itsParent = parent; }
+    void SetParent(Node * parent) {
+        itsParent = parent;
+        itsAncestors = AncestorsOf(parent);
+    }
     double GetMeanCost() const { return itsMeanCost; }
     void SetMeanCost(double cost) { itsMeanCost = cost; }
     double GetVarCost() const { return itsVarCost; }
@@ -201,13 +230,37 @@ class Node {
     double GetMeanCTG() const { return itsMeanCTG; }
     double GetVarCTG() const { return itsVarCTG; }
 
+    //! True if v is the vertex of a strict ancestor of this node. The
+    //! ancestor mask rules out most vertices without walking the path.
+    bool HasAncestor(const Vertex * v) const {
+        if (!(itsAncestors & VertexBit(v)))
+            return false;
+        for (Node * n0 = itsParent; n0; n0 = n0->GetParent())
+            if (n0->GetVertex() == v)
+                return true;
+        return false;
+    }
+
     void DisplayPath();
-    Node * ReverseList(Node * itsChild);
+    //! Copies the path ending here into arena, reversed, and returns the
+    //! copy of the first node
+    Node * ReverseList(Node * itsChild, NodeArena<Node> * arena);
     void SetCTG(double totalMean, double totalVar);
 
  private:
     Vertex * itsVertex;
     Node * itsParent;
+    // Bloom filter of ancestor vertex IDs, one bit per ID modulo 64
+    unsigned long long itsAncestors;
+
+    static unsigned long long VertexBit(const Vertex * v) {
+        return 1ULL << (v->GetID() % 64);
+    }
+    static unsigned long long AncestorsOf(const Node * parent) {
+        if (!parent)
+            return 0;
+        return parent->itsAncestors | VertexBit(parent->GetVertex());
+    }
     double itsMeanCost;
     double itsVarCost;
     ULONG itsDepth;
@@ -241,27 +294,22 @@ namespace ryan {
 class Queue {
  public:
     typedef std::priority_queue<Node *, std::vector<Node *>, CompareNode> QUEUE;
-    explicit Queue(Node * source) {
+    Queue(Node * source, ULONG numVertices) : itsFronts(numVertices) {
         itsPQ = new QUEUE;
         itsPQ->push(source);
     }
 
+    // Nodes belong to the search's arena, not the queue
     ~Queue() {
-        while (!itsPQ->empty()) {
-            Node * temp = itsPQ->top();
-            delete temp;
-            temp = 0;
-            itsPQ->pop();
-        }
         delete itsPQ;
         itsPQ = 0;
-        for (ULONG i = 0; i < closed.size(); i++) {
-            delete closed[i];
-            closed[i] = 0;
-        }
     }
 
-    std::vector<Node *> GetClosed() const { return closed; }
+    const std::vector<Node *>& GetClosed() const { return closed; }
+    //! True if any node at vertex v has been closed
+    bool IsClosed(const Vertex * v) const {
+        return !itsFronts[v->GetID()].empty();
+    }
     bool EmptyQueue() const { return itsPQ->empty(); }
     ULONG SizeQueue() const { return (ULONG)itsPQ->size(); }
     void UpdateQueue(Node * newNode);
@@ -271,7 +319,13 @@ class Queue {
     QUEUE * itsPQ;
     std::vector<Node *> closed;
 
+    // Closed nodes per vertex ID that no other closed node dominates, sorted
+    // by increasing mean cost (and so decreasing variance)
+    std::vector<std::vector<Node *> > itsFronts;
+
     bool CompareNodes(const Node * n1, const Node * n2) const;
+    bool IsDominated(const Node * n) const;
+    void Close(Node * n);
 };
 }
 
@@ -279,8 +333,11 @@ class Queue {
 // A* search with zero, Manhattan or Euclidean distance heuristics
 class Search {
  public:
+    //! Searches stop after creating this many nodes
+    static const ULONG k_node_budget = 1000000;
+
     Search(Graph * graph, Vertex * source, Vertex * goal) :
-        itsGraph(graph), itsSource(source), itsGoal(goal) {
+        itsGraph(graph), itsQueue(0), itsSource(source), itsGoal(goal) {
         SEARCH_TYPE = ASTAR;
         HEURISTIC = ZERO;
     }
@@ -295,10 +352,12 @@ class Search {
     void SetQueue(ryan::Queue * q) { itsQueue = q; }
     Vertex * GetSource() const { return itsSource; }
     Vertex * GetGoal() const { return itsGoal; }
+    //! Returned nodes stay valid until the next search or destruction
     std::vector<Node *> PathSearch(pathOut pType);
 
  private:
     Graph * itsGraph;
+    NodeArena<Node> itsNodes;
     ryan::Queue * itsQueue;
     Vertex * itsSource;
     Vertex * itsGoal;
@@ -311,22 +370,72 @@ class Search {
     void UpdateNode(Node * n);
 };
 
+// Probability of improvement between candidate next vertices. The total cost
+// through a vertex is its cost-to-come plus the least cost-to-go over its
+// nodes, each normally distributed. Each vertex's density and survival
+// function of total cost are tabulated once, on a grid shared by all the
+// candidates, so each comparison is a single dot product. Paths with no
+// variance are point masses, whose share is computed exactly per pair.
+class ImprovementTable {
+ public:
+    //! samples: grid points across the narrowest vertex's cost range
+    explicit ImprovementTable(const std::vector<Vertex *> &vertices,
+        ULONG samples = 100);
+
+    //! Probability that vertex j (an index into vertices) costs less than i
+    double Probability(ULONG i, ULONG j) const;
+
+ private:
+    double itsStep;
+    std::vector<std::vector<double> > itsDensity;  // [vertex][sample]
+    std::vector<std::vector<double> > itsSurvival;  // [vertex][sample]
+    std::vector<std::vector<double> > itsPointMass;  // [vertex][vertex]
+};
+
+// Probability that B costs less than A, by adaptive Simpson quadrature
+double ComputeImprovementProbability(Vertex * A, Vertex * B,
+    double tolerance);
+
 // RAGS class for interfacing with sector agents
 class RAGS {
  public:
     typedef std::pair<int, int> edge;
+
+    //! One traveller's place in the path sets of a shared RAGS instance:
+    //! the edge it is on, the paths still open at its end, and the vertex
+    //! chosen beyond that. Everything else is shared between travellers.
+    class Cursor {
+     public:
+        Cursor() : itsGeneration(0), itsVert(0), itsNext(0), itsAhead(0),
+            itsGoal(0) {}
+
+     private:
+        friend class RAGS;
+        ULONG itsGeneration;  // path sets the nodes below belong to
+        Vertex * itsVert;
+        Vertex * itsNext;
+        Vertex * itsAhead;
+        Vertex * itsGoal;
+        std::vector<Node *> itsNextNodes;  // at itsNext
+        std::vector<Node *> itsAheadNodes;  // at itsAhead
+    };
+
     RAGS(const std::vector<easymath::XY> &locations,
         const std::vector<edge> &edge_array, const matrix2d &weights) :
-        itsLocations(locations), itsEdgeArray(edge_array) {
+        itsLocations(locations), itsEdgeArray(edge_array), itsSearch(0),
+        itsVert(0), itsCostCount(0), itsForgetting(0.0), itsGeneration(1) {
         itsGraph = new Graph(locations, edge_array, weights);
         PSET = BEST;  // BEST = ASTAR; ALL = RAGS
+        QUAD = TABULATED;
     }
 
     RAGS(const std::vector<easymath::XY> &locations,
         const std::vector<edge> &edge_array) :
-        itsLocations(locations), itsEdgeArray(edge_array) {
+        itsLocations(locations), itsEdgeArray(edge_array), itsSearch(0),
+        itsVert(0), itsCostCount(0), itsForgetting(0.0), itsGeneration(1) {
         itsGraph = new Graph(locations, edge_array);
         PSET = BEST;  // BEST = ASTAR; ALL = RAGS
+        QUAD = TABULATED;
     }
 
     ~RAGS() {
@@ -334,21 +443,14 @@ class RAGS {
         itsGraph = 0;
         delete itsSearch;
         itsSearch = 0;
-        for (unsigned i = 0; i < itsNDSet.size(); i++) {
-            Node * hN;
-            Node * pN = itsNDSet[i]->GetParent();
-            while (pN) {
-                hN = pN->GetParent();
-                delete pN;
-                pN = hN;
-            }
-            delete itsNDSet[i];
-            itsNDSet[i] = 0;
-        }
     }
 
     Graph * GetGraph() const { return itsGraph; }
     Vertex * GetVert() const { return itsVert; }
+    void SetQuadrature(quadrature q) { QUAD = q; }
+    //! Weight of the newest sample in edge cost statistics once it exceeds
+    //! 1/t; 0 weights all samples equally
+    void SetForgetting(double alpha) { itsForgetting = alpha; }
 
     void SetInitialVert(Vertex * start);
     easymath::XY SearchGraph(const easymath::XY& start,
@@ -357,6 +459,20 @@ class RAGS {
         const matrix1d &weights);
     int GetEdgeIndex(easymath::XY start, easymath::XY goal);
 
+    //! Records edge costs (by edge array index) for every traveller, once
+    //! per step. If they changed, the non-dominated path sets are searched
+    //! again when next used.
+    void UpdateEdgeCosts(const matrix1d &weights);
+    //! Plans from vertex start to goal for the traveller at cursor. Each
+    //! vertex is picked by probability of improvement over the shared
+    //! non-dominated paths, one edge ahead of the traveller: the choice
+    //! after the next vertex may change on every call, but is kept once the
+    //! traveller reaches the next vertex. The rest of the path follows the
+    //! cheapest expected path. Returns false, with an empty path, if goal
+    //! cannot be reached.
+    bool PlanPath(Cursor * cursor, ULONG start, ULONG goal,
+        std::vector<size_t> * path);
+
  private:
     std::vector<easymath::XY> itsLocations;
     std::vector<edge> itsEdgeArray;
@@ -364,10 +480,35 @@ class RAGS {
     Search * itsSearch;
     Vertex * itsVert;
     std::vector<Node *> itsNDSet;
+    NodeArena<Node> itsNDNodes;  // reversed paths behind itsNDSet
     pathOut PSET;
+    quadrature QUAD;  // how next vertices are compared
+    static const double k_quad_tolerance;
+
+    // Running edge cost statistics, [edge]
+    size_t itsCostCount;
+    matrix1d itsCostMean;
+    matrix1d itsCostVar;
+    double itsForgetting;
 
-    matrix2d weights_history;  // [t][edge]
     void AssignCurrentEdgeCosts(const matrix1d &weights);
     void AssignCurrentMeansAndVariances();
+
+    // Non-dominated paths shared by cursors, [(start, goal)], and the
+    // edge costs they were searched with
+    ULONG itsGeneration;
+    matrix1d itsLastWeights;
+    std::map<std::pair<ULONG, ULONG>, std::vector<Node *> > itsPathSets;
+    NodeArena<Node> itsPathSetNodes;
+
+    const std::vector<Node *>& GetPathSet(Vertex * start, Vertex * goal);
+
+    //! Next vertex along nodes (paths at vert), or NULL at the goal. Sets
+    //! each candidate's nodes to those paths' nodes there.
+    Vertex * SelectNextVertex(Vertex * vert, const std::vector<Node *> &nodes);
+
+    //! Index of the next vertex to move to
+    ULONG RankNextVertices(Vertex * vert,
+        const std::vector<Vertex *> &nextVerts);
 };
 #endif  // PLANNING_RAGS_H_
@@ -1,32 +1,88 @@
 // Copyright 2016 Carrie Rebhuhn
 #include "GridGraph.h"
 
+#include <algorithm>
+
 using std::vector;
 using easymath::XY;
 using easymath::operator <;
 
 GridGraph::GridGraph(barrier_grid obstacle_map) : GridBase(),
-m_grid(create_grid(obstacle_map.size(), obstacle_map[0].size())),
+    m_x_dim(obstacle_map.size()), m_y_dim(obstacle_map[0].size()),
+    m_obstacles(m_x_dim*m_y_dim), m_barriers(&m_obstacles),
+    m_grid(create_grid(m_x_dim, m_y_dim)),
     g(create_barrier_grid()) {
     /**
     * This map shows all grid cells except those in obstacle_map as passable.
     */
-    int v_index = 0;
-    for (size_t y = 0; y < obstacle_map[0].size(); y++) {
-        for (size_t x = 0; x < obstacle_map.size(); x++) {
+    for (size_t y = 0; y < m_y_dim; y++) {
+        for (size_t x = 0; x < m_x_dim; x++) {
             // Place barriers
-            if (obstacle_map[x][y]) {
-                vertex_descriptor u = { x, y };
-                m_barriers.insert(u);
-            }
-            // Increment vertex index even if no barrier added
-            v_index++;
+            if (obstacle_map[x][y])
+                m_obstacles.set(x + y*m_x_dim);
         }
     }
 }
 
 GridGraph::GridGraph(const matrix2d &members_set) : GridGraph(members_set < 0) {
     members = members_set;
+    set_sector_cells();
+}
+
+GridGraph::GridGraph(const GridGraph &other) : GridBase(),
+    members(other.members), m_x_dim(other.m_x_dim), m_y_dim(other.m_y_dim),
+    m_obstacles(other.m_obstacles), m_sector_cells(other.m_sector_cells),
+    m_occlusion_masks(other.m_occlusion_masks), m_barriers(&m_obstacles),
+    m_grid(create_grid(m_x_dim, m_y_dim)),
+    g(create_barrier_grid()) {
+    // Point at our own copy of whichever mask the other graph had active
+    for (auto &m : other.m_occlusion_masks) {
+        if (&m.second == other.m_barriers)
+            m_barriers = &m_occlusion_masks.at(m.first);
+    }
+}
+
+void GridGraph::set_sector_cells() {
+    // One bitset per membership, so sector pairs can be combined by word
+    int n_sectors = 0;
+    for (const matrix1d &col : members)
+        for (double m : col)
+            n_sectors = std::max(n_sectors, static_cast<int>(m) + 1);
+
+    m_sector_cells.assign(n_sectors, barrier_bitset(m_x_dim*m_y_dim));
+    for (size_t y = 0; y < m_y_dim; y++) {
+        for (size_t x = 0; x < m_x_dim; x++) {
+            int m = static_cast<int>(members[x][y]);
+            if (m >= 0)
+                m_sector_cells[m].set(x + y*m_x_dim);
+        }
+    }
+}
+
+const barrier_bitset& GridGraph::get_occlusion_mask(int m1, int m2) {
+    sector_pair key = std::make_pair(std::min(m1, m2), std::max(m1, m2));
+    auto found = m_occlusion_masks.find(key);
+    if (found != m_occlusion_masks.end())
+        return found->second;
+
+    // Everything outside of m1 and m2 is a barrier, as are obstacles
+    barrier_bitset passable(m_x_dim*m_y_dim);
+    int n_sectors = static_cast<int>(m_sector_cells.size());
+    if (m1 >= 0 && m1 < n_sectors)
+        passable |= m_sector_cells[m1];
+    if (m2 >= 0 && m2 < n_sectors)
+        passable |= m_sector_cells[m2];
+
+    barrier_bitset &mask = m_occlusion_masks[key];
+    mask = ~passable;
+    mask |= m_obstacles;
+    return mask;
+}
+
+void GridGraph::precompute_occlusion_masks(const vector<edge> &sector_pairs) {
+    for (const edge &e : sector_pairs)
+        get_occlusion_mask(static_cast<int>(e.first),
+            static_cast<int>(e.second));
 }
 
 void GridGraph::occlude_nonmembers(int m1, int m2) {
@@ -35,20 +91,7 @@ void GridGraph::occlude_nonmembers(int m1, int m2) {
     * Others are barriers. Backflow (travel from m2 to m1) is allowed but will
     * tend to be suboptimal, so is improbable.
     */
-    int v_index = 0;
-    for (size_t y = 0; y < members[0].size(); y++) {
-        for (size_t x = 0; x < members.size(); x++) {
-            // Place barriers
-            bool obstacle = members[x][y] < 0;
-            bool wrong_member = (members[x][y] != m1 && members[x][y] != m2);
-            if (obstacle || wrong_member) {
-                vertex_descriptor u = { x, y };
-                m_barriers.insert(u);
-            }
-            // Increment vertex index even if no barrier added
-            v_index++;
-        }
-    }
+    m_barriers = &get_occlusion_mask(m1, m2);
 }
 
 grid GridGraph::create_grid(std::size_t x, std::size_t y) {
@@ -57,5 +100,6 @@ grid GridGraph::create_grid(std::size_t x, std::size_t y) {
 }
 
 GridGraph::filtered_grid GridGraph::create_barrier_grid() {
-    return boost::make_vertex_subset_complement_filter(m_grid, m_barriers);
+    return filtered_grid(m_grid, boost::keep_all(),
+        barrier_filter(&m_barriers, m_x_dim));
 }
@@ -0,0 +1,97 @@
+// Copyright 2016 Carrie Rebhuhn
+#include "HierarchicalGraph.h"
+
+#include <list>
+#include <map>
+#include <vector>
+
+using std::map;
+using std::vector;
+using easymath::XY;
+
+HierarchicalGraph::HierarchicalGraph(GridGraph* low_graph,
+    const vector<edge> &sector_edges) : low_graph_(low_graph) {
+    findTransitions();
+    cacheIntraPaths(sector_edges);
+}
+
+void HierarchicalGraph::findTransitions() {
+    // Collect every pair of 4-connected cells that straddle a border
+    const matrix2d &members = low_graph_->members;
+    map<edge, vector<transition> > candidates;
+    for (size_t x = 0; x < members.size(); x++) {
+        for (size_t y = 0; y < members[x].size(); y++) {
+            int m1 = static_cast<int>(members[x][y]);
+            if (m1 < 0) continue;
+            XY c1(static_cast<double>(x), static_cast<double>(y));
+
+            XY neighbours[2] = { XY(c1.x + 1, c1.y), XY(c1.x, c1.y + 1) };
+            for (XY c2 : neighbours) {
+                size_t x2 = static_cast<size_t>(c2.x);
+                size_t y2 = static_cast<size_t>(c2.y);
+                if (x2 >= members.size() || y2 >= members[x2].size())
+                    continue;
+                int m2 = static_cast<int>(members[x2][y2]);
+                if (m2 < 0 || m2 == m1) continue;
+
+                candidates[edge(m1, m2)].push_back({ c1, c2 });
+                candidates[edge(m2, m1)].push_back({ c2, c1 });
+            }
+        }
+    }
+
+    // Use the middle of each border as its entrance
+    for (auto &c : candidates)
+        transitions_[c.first] = c.second[c.second.size() / 2];
+}
+
+void HierarchicalGraph::cacheIntraPaths(const vector<edge> &sector_edges) {
+    // Inside each sector, connect every entrance to every exit
+    map<size_t, vector<XY> > entries, exits;
+    for (const edge &e : sector_edges) {
+        if (!has_transition(e.first, e.second)) continue;
+        const transition &t = get_transition(e.first, e.second);
+        exits[e.first].push_back(t.exit);
+        entries[e.second].push_back(t.entry);
+    }
+
+    for (auto &s : entries)
+        for (const XY &from : s.second)
+            for (const XY &to : exits[s.first])
+                getIntraPath(from, to);
+}
+
+HierarchicalGraph::grid_path HierarchicalGraph::findIntraPath(XY from,
+    XY to) {
+    int s = low_graph_->get_membership(from);
+    low_graph_->occlude_nonmembers(s, s);
+    grid_path p = Planning::astar(low_graph_, from, to);
+    low_graph_->clear_occlusion();
+    return p;
+}
+
+const HierarchicalGraph::grid_path& HierarchicalGraph::getIntraPath(XY from,
+    XY to) {
+    auto key = std::make_pair(from, to);
+    auto found = intra_paths_.find(key);
+    if (found != intra_paths_.end())
+        return found->second;
+    return intra_paths_[key] = findIntraPath(from, to);
+}
+
+HierarchicalGraph::grid_path HierarchicalGraph::get_leg(XY start, size_t cur,
+    size_t next) {
+    if (!has_transition(cur, next))
+        return grid_path();
+
+    // A UAV can start anywhere in its sector; caching from every such cell
+    // would grow without bound, so only entrances are looked up
+    const transition &t = get_transition(cur, next);
+    auto cached = intra_paths_.find(std::make_pair(start, t.exit));
+    grid_path leg = cached != intra_paths_.end() ? cached->second
+        : findIntraPath(start, t.exit);
+    if (leg.empty())
+        return leg;
+    leg.push_back(t.entry);
+    return leg;
+}
@@ -1,73 +1,240 @@
 // Copyright 2016 Carrie Rebhuhn
 #include "LinkGraph.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
 #include <string>
 #include <list>
 #include <vector>
 
+#include "Math/include/SpatialHash.h"
+
 using std::string;
 using std::list;
 using std::vector;
 using easymath::XY;
 using easymath::get_n_unique_square_points;
 using easymath::all_combos_of_2;
-using easymath::zeros;
 using easymath::line_segment;
 using easymath::intersects_in_center;
+using easymath::xy_buffer;
+using easymath::segment_buffer;
+using easymath::first_intersecting_in_center;
+using easymath::first_pt_on_line;
+
+const size_t LinkGraph::k_max_dense_vertices;
+const size_t LinkGraph::k_no_link;
+const size_t LinkGraph::k_max_all_pairs_vertices;
+const double LinkGraph::k_candidate_radius = 3.0;
 
-LinkGraph::LinkGraph(size_t n_vertices, size_t xdim, size_t ydim) :
-    g(n_vertices) {
+LinkGraph::LinkGraph(size_t n_vertices, size_t xdim, size_t ydim) {
     locations = get_n_unique_square_points(0.0, static_cast<double>(xdim),
         0.0, static_cast<double>(ydim), n_vertices);
 
-    for (size_t i = 0; i < n_vertices; i++) {
-        loc2mem[locations[i]] = i;  // add in reverse lookup
-    }
+    loc2mem = easymath::PointIndex(locations);  // add in reverse lookup
 
-    vector<edge> candidates = all_combos_of_2(n_vertices);
-    random_shuffle(candidates.begin(), candidates.end());
+    // Mean distance between neighbouring vertices
+    double spacing = sqrt(static_cast<double>(xdim*ydim)
+        / static_cast<double>(std::max<size_t>(n_vertices, 1)));
+    spacing = std::max(spacing, 1.0);
+
+    // Small graphs consider every pair of vertices; in large graphs, long
+    // edges are nearly always blocked, so only nearby pairs are candidates
+    vector<edge> candidates;
+    if (n_vertices <= k_max_all_pairs_vertices) {
+        candidates = all_combos_of_2(n_vertices);
+    } else {
+        easymath::SpatialHash near(k_candidate_radius*spacing);
+        for (const XY &p : locations)
+            near.insert(p);
+        near.for_each_pair_within(k_candidate_radius*spacing,
+            [&candidates](size_t i, size_t j) {
+            candidates.push_back(edge(std::min(i, j), std::max(i, j)));
+        });
+        std::sort(candidates.begin(), candidates.end());
+    }
+    easymath::shuffle(candidates.begin(), candidates.end(),
+        easymath::RNG_GRAPH);
 
     // Add as many edges as possible, while still planar
-    for (edge c : candidates) {
-        if (!intersects_existing_edge(c)) {
-            boost::add_edge(c.first, c.second, g);
-            boost::add_edge(c.second, c.first, g);
+    add_planar_edges(candidates, spacing);
+
+    // Number links by source, as the adjacency list used to
+    vector<edge> edge_array = m_edges;
+    std::stable_sort(edge_array.begin(), edge_array.end(),
+        [](const edge &a, const edge &b) { return a.first < b.first; });
+    set_edges(edge_array);
+}
+
+LinkGraph::LinkGraph() : LinkGraph(1, 1, 1) {}
+
+void LinkGraph::add_planar_edges(const vector<edge> &candidates,
+    double cell_size) {
+    /**
+    * Same result as testing each candidate with intersects_existing_edge,
+    * but vertices and accepted edges are bucketed into a grid by bounding
+    * box. An edge or vertex can only block a candidate if it shares one of
+    * the cells covered by the candidate's bounding box.
+    */
+    double x_max = 0.0, y_max = 0.0;
+    for (const XY &p : locations) {
+        x_max = std::max(x_max, p.x);
+        y_max = std::max(y_max, p.y);
+    }
+    size_t nx = static_cast<size_t>(x_max / cell_size) + 1;
+    size_t ny = static_cast<size_t>(y_max / cell_size) + 1;
+    auto cell_x = [&](double x) {
+        return std::min(static_cast<size_t>(std::max(x, 0.0) / cell_size),
+            nx - 1);
+    };
+    auto cell_y = [&](double y) {
+        return std::min(static_cast<size_t>(std::max(y, 0.0) / cell_size),
+            ny - 1);
+    };
+
+    // Each cell keeps its vertices and edges as batches for the easymath
+    // segment tests. Edges go in both directions, as both are in m_edges;
+    // the test is not exact for segments that share an endpoint.
+    vector<xy_buffer> vertex_cells(nx*ny);
+    vector<segment_buffer> edge_cells(nx*ny);
+    for (const XY &p : locations)
+        vertex_cells[cell_x(p.x) + nx*cell_y(p.y)].push_back(p);
+
+    for (const edge &c : candidates) {
+        line_segment b(locations[c.first], locations[c.second]);
+        size_t x0 = cell_x(std::min(b.first.x, b.second.x));
+        size_t x1 = cell_x(std::max(b.first.x, b.second.x));
+        size_t y0 = cell_y(std::min(b.first.y, b.second.y));
+        size_t y1 = cell_y(std::max(b.first.y, b.second.y));
+
+        bool blocked = false;
+        for (size_t y = y0; y <= y1 && !blocked; y++) {
+            for (size_t x = x0; x <= x1 && !blocked; x++) {
+                const segment_buffer &cell = edge_cells[x + nx*y];
+                blocked = first_intersecting_in_center(cell, b) < cell.size();
+            }
+        }
+
+        // Vertices are only checked once no edge blocks the candidate
+        for (size_t y = y0; y <= y1 && !blocked; y++) {
+            for (size_t x = x0; x <= x1 && !blocked; x++) {
+                const xy_buffer &cell = vertex_cells[x + nx*y];
+                blocked = first_pt_on_line(cell, b) < cell.size();
+            }
+        }
+        if (blocked) continue;
+
+        m_edges.push_back(c);
+        m_edges.push_back(edge(c.second, c.first));
+        line_segment b_reversed(b.second, b.first);
+        for (size_t y = y0; y <= y1; y++) {
+            for (size_t x = x0; x <= x1; x++) {
+                edge_cells[x + nx*y].push_back(b);
+                edge_cells[x + nx*y].push_back(b_reversed);
+            }
         }
     }
 }
 
-vector<LinkGraph::edge> LinkGraph::get_edges() const {
-    edge_iter ei, ei_end;
-    vector<edge> edges_out(get_n_edges());
-    size_t index = 0;
-    for (boost::tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        edges_out[index++] = edge((*ei).m_source, (*ei).m_target);
-    }
-    return edges_out;
+
+LinkGraph::LinkGraph(vector<XY> locs, const vector<edge> &edge_array) :
+    LinkBase(), locations(locs), loc2mem(locs) {
+
+    set_edges(edge_array);
 }
 
-LinkGraph::LinkGraph() : LinkGraph(1, 1, 1) {}
+void LinkGraph::set_edges(const vector<edge> &edge_array) {
+    size_t n_vertices = locations.size();
+    m_edges = edge_array;
+    m_weights.assign(m_edges.size(), 1.0);
 
+    // Link geometry never changes, so it is worked out once here
+    m_lengths.clear();
+    m_directions.clear();
+    m_segments.clear();
+    for (const edge &e : m_edges) {
+        XY s = locations[e.first];
+        XY t = locations[e.second];
+        m_lengths.push_back(euclidean_distance(s, t));
+        m_directions.push_back(cardinal_direction(s - t));
+        m_segments.push_back(line_segment(s, t));
+    }
+    m_points.clear();
+    for (const XY &p : locations)
+        m_points.push_back(p);
 
-LinkGraph::LinkGraph(vector<XY> locs, const vector<edge> &edge_array) :
-    LinkBase(), locations(locs) {
-    for (size_t i = 0; i < locs.size(); i++)
-        loc2mem[locs[i]] = i;
+    // Boost view, remembering each link's descriptor so weights stay in sync
+    g = mygraph_t(n_vertices);
+    m_descriptors.clear();
+    for (const edge &e : m_edges) {
+        m_descriptors.push_back(boost::add_edge(e.first, e.second, g).first);
+        put(boost::edge_weight, g, m_descriptors.back(), 1.0);
+    }
 
-    g = mygraph_t(edge_array.begin(), edge_array.end(), locations.size());
-    set_weights(matrix1d(edge_array.size(), 1.0));
+    // Count out-links per source, then fill each row in target order
+    m_row_offsets.assign(n_vertices + 1, 0);
+    for (const edge &e : m_edges)
+        m_row_offsets[e.first + 1]++;
+    for (size_t v = 0; v < n_vertices; v++)
+        m_row_offsets[v + 1] += m_row_offsets[v];
+
+    vector<size_t> order(m_edges.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return m_edges[a] < m_edges[b];
+    });
+
+    m_col_targets.resize(m_edges.size());
+    m_col_links.resize(m_edges.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        m_col_targets[i] = m_edges[order[i]].second;
+        m_col_links[i] = order[i];
+    }
+
+    m_link_table.clear();
+    if (n_vertices <= k_max_dense_vertices) {
+        m_link_table.assign(n_vertices*n_vertices, k_no_link);
+        for (size_t i = m_edges.size(); i-- > 0;)
+            m_link_table[m_edges[i].first*n_vertices + m_edges[i].second] = i;
+    }
+}
+
+size_t LinkGraph::find_link(size_t source, size_t target) const {
+    size_t n_vertices = locations.size();
+    if (!m_link_table.empty()) {
+        if (source < n_vertices && target < n_vertices)
+            return m_link_table[source*n_vertices + target];
+    } else if (source + 1 < m_row_offsets.size()) {
+        auto first = m_col_targets.begin() + m_row_offsets[source];
+        auto last = m_col_targets.begin() + m_row_offsets[source + 1];
+        auto found = std::lower_bound(first, last, target);
+        if (found != last && *found == target)
+            return m_col_links[found - m_col_targets.begin()];
+    }
+    return k_no_link;
+}
+
+size_t LinkGraph::get_link_id(size_t source, size_t target) const {
+    size_t link = find_link(source, target);
+    if (link == k_no_link)
+        throw std::out_of_range("LinkGraph: no link between vertices");
+    return link;
 }
 
 //! This allows the blocking and unblocking of sectors by making travel
 //! through a sector highly suboptimal.
 void LinkGraph::blockVertex(int vertexID) {
     // Makes it highly suboptimal to travel to a vertex
-    saved_weights = get_weights();
+    saved_weights = m_weights;
 
-    edge_iter ei, ei_end;
-    for (boost::tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        if ((*ei).m_target == vertex_descriptor(vertexID))
-            put(boost::edge_weight, g, *ei, 999999.99);
+    for (size_t i = 0; i < m_edges.size(); i++) {
+        if (m_edges[i].second == vertex_descriptor(vertexID)) {
+            m_weights[i] = 999999.99;
+            put(boost::edge_weight, g, m_descriptors[i], m_weights[i]);
+        }
     }
 }
 
@@ -75,40 +242,42 @@ void LinkGraph::unblockVertex() {
     set_weights(saved_weights);
 }
 
-void LinkGraph::set_weights(matrix1d weights) {
-    // iterate over all edge descriptors...
-    typedef boost::graph_traits<mygraph_t>::edge_iterator edge_iter;
-    edge_iter ei, ei_end;
-    size_t i = 0;
-
-    for (boost::tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        put(boost::edge_weight, g, *ei, weights[i++]);
-    }
-}
-
-matrix1d LinkGraph::get_weights() const {
-    edge_iter ei, ei_end;
-    matrix1d weights;
-    for (boost::tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        weights.push_back(get(boost::edge_weight, g, *ei));
-    }
-    return weights;
+void LinkGraph::set_weights(const matrix1d &weights) {
+    // Weights arrive in link order, so this is a straight copy
+    std::copy(weights.begin(), weights.begin() + m_weights.size(),
+        m_weights.begin());
+    for (size_t i = 0; i < m_weights.size(); i++)
+        put(boost::edge_weight, g, m_descriptors[i], m_weights[i]);
 }
 
 void LinkGraph::print_graph(string file_path) {
-    matrix2d connections_matrix = zeros(locations.size(), locations.size());
-
-    for (auto ei = edges(g).first; ei != edges(g).second; ++ei) {
-        connections_matrix[(*ei).m_source][(*ei).m_target] = true;
-    }
-
     string CONNECTIONS_FILE = file_path + "connections.csv";
     string NODES_FILE = file_path + "nodes.csv";
     string EDGES_FILE = file_path + "edges.csv";
 
-    FileOut::print_pair_container(locations, NODES_FILE);
+    FileOut::print_xy_container(locations, NODES_FILE);
     FileOut::print_pair_container(get_edges(), EDGES_FILE);
-    FileOut::print_vector(connections_matrix, CONNECTIONS_FILE);
+
+    // The connection matrix is written a row at a time from the CSR rows,
+    // rather than built in full: it is V x V
+    std::ofstream file(CONNECTIONS_FILE.c_str(),
+        std::ofstream::out | std::ofstream::trunc);
+    if (!file.is_open()) {
+        FileErrors::failed_file(CONNECTIONS_FILE);
+        return;
+    }
+    size_t n_vertices = locations.size();
+    string row;
+    for (size_t v = 0; v < n_vertices; v++) {
+        row.assign(2*n_vertices, ',');
+        for (size_t i = 0; i < n_vertices; i++)
+            row[2*i] = '0';
+        for (size_t i = m_row_offsets[v]; i < m_row_offsets[v + 1]; i++)
+            row[2*m_col_targets[i]] = '1';
+        file << row << "\n";
+    }
+    file.close();
+    printf("... Successfully wrote to file %s.\n", CONNECTIONS_FILE.c_str());
 }
 
 bool LinkGraph::fully_connected() {
@@ -127,26 +296,20 @@ bool LinkGraph::intersects_existing_edge(edge candidate) {
     XY b2 = locations[candidate.second];
     line_segment b = line_segment(b1, b2);
 
-    edge_iter ei, ei_end;
-    for (boost::tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        XY a1 = locations[(*ei).m_source];
-        XY a2 = locations[(*ei).m_target];
-        line_segment a = line_segment(a1, a2);
-
-        if (intersects_in_center(a, b))
-            return true;
-    }
+    if (first_intersecting_in_center(m_segments, b) < m_segments.size())
+        return true;
 
     // Check if any agent locations are being crossed by an edge
     // Exclude case where agent is at endpoint
-    for (XY a : locations) {
-        if (!is_endpt(a, b) && pt_on_line(a, b))
-            return true;
-    }
-    return false;
+    return first_pt_on_line(m_points, b) < m_points.size();
 }
 
 size_t LinkGraph::get_direction(size_t m1, size_t m2) const {
+    size_t link = find_link(m1, m2);
+    if (link != k_no_link)
+        return m_directions[link];
+
+    // Not a link, so there is no table entry
     XY a = get_vertex_loc(m1);
     XY b = get_vertex_loc(m2);
     return cardinal_direction(a - b);
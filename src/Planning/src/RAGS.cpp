@@ -1,5 +1,6 @@
 // Copyright 2016 Jen Jen Chung, Ryan Skeele, Carrie Rebhuhn
 #include "RAGS.h"
+#include <cmath>
 #include <vector>
 #include <algorithm>
 using std::vector;
@@ -9,6 +10,8 @@ using std::cout;
 using std::endl;
 using easymath::XY;
 
+const double RAGS::k_quad_tolerance = 1e-6;
+
 void Edge::SetTrueCost(default_random_engine generator) {
     double diff_x = itsVertex1->GetX() - itsVertex2->GetX();
     double diff_y = itsVertex1->GetY() - itsVertex2->GetY();
@@ -20,59 +23,28 @@ void Edge::SetTrueCost(default_random_engine generator) {
 }
 
 vector<Edge *> Graph::GetNeighbours(XY v) {
-    Vertex * pV = NULL;
-    for (ULONG i = 0; i < numVertices; i++)
-        if (v.x == itsVertices[i]->GetX() && v.y == itsVertices[i]->GetY())
-            pV = itsVertices[i];
-
-    return GetNeighbours(pV);
+    return GetNeighbours(FindVertex(v));
 }
 
 vector<Edge *> Graph::GetNeighbours(Vertex * v) {
-    vector<Edge *> neighbours(numEdges);
-    ULONG k = 0;
-
-    for (ULONG i = 0; i < numEdges; i++) {
-        double x1 = itsEdges[i]->GetVertex1()->GetX();
-        double y1 = itsEdges[i]->GetVertex1()->GetY();
-        if (x1 == v->GetX() && y1 == v->GetY()) {
-            neighbours[k] = itsEdges[i];
-            k++;
-        }
-    }
-
-    neighbours.resize(k);
-    return neighbours;
+    ULONG id = v->GetID();
+    return vector<Edge *>(itsOutEdges.begin() + itsOutStart[id],
+        itsOutEdges.begin() + itsOutStart[id + 1]);
 }
 
 // Do not include parent vertex in list of neighbours
 vector<Edge *> Graph::GetNeighbours(const XY& v, const XY& v0) {
-    Vertex * pV = NULL;
-    Vertex * pV0 = NULL;
-    for (ULONG i = 0; i < numVertices; i++) {
-        if (v.x == itsVertices[i]->GetX() && v.y == itsVertices[i]->GetY())
-            pV = itsVertices[i];
-        if (v0.x == itsVertices[i]->GetX() && v0.y == itsVertices[i]->GetY())
-            pV0 = itsVertices[i];
-    }
-
-    return GetNeighbours(pV, pV0);
+    return GetNeighbours(FindVertex(v), FindVertex(v0));
 }
 
 // Do not include parent vertex in list of neighbours
 vector<Edge *> Graph::GetNeighbours(Vertex * v, Vertex * v0) {
     vector<Edge *> neighbours;
 
-    for (ULONG i = 0; i < numEdges; i++) {
-        double x1 = itsEdges[i]->GetVertex1()->GetX();
-        double y1 = itsEdges[i]->GetVertex1()->GetY();
-        double x2 = itsEdges[i]->GetVertex2()->GetX();
-        double y2 = itsEdges[i]->GetVertex2()->GetY();
-        if (x1 == v->GetX() && y1 == v->GetY() && x2 != v0->GetX()
-            && y2 != v0->GetY()) {
-            neighbours.push_back(itsEdges[i]);
-        }
-    }
+    ULONG id = v->GetID();
+    for (ULONG i = itsOutStart[id]; i < itsOutStart[id + 1]; i++)
+        if (itsOutEdges[i]->GetVertex2() != v0)
+            neighbours.push_back(itsOutEdges[i]);
 
     return neighbours;
 }
@@ -80,41 +52,25 @@ vector<Edge *> Graph::GetNeighbours(Vertex * v, Vertex * v0) {
 // Do not include parent vertex in list of neighbours
 vector<Edge *> Graph::GetNeighbours(Node * n) {
     vector<Edge *> neighbours;
-    Vertex * v = n->GetVertex();
 
-    for (ULONG i = 0; i < numEdges; i++) {
-        double x1 = itsEdges[i]->GetVertex1()->GetX();
-        double y1 = itsEdges[i]->GetVertex1()->GetY();
-        double x2 = itsEdges[i]->GetVertex2()->GetX();
-        double y2 = itsEdges[i]->GetVertex2()->GetY();
-        if (x1 == v->GetX() && y1 == v->GetY()) {
-            bool isNeighbour = true;
-            Node * n0 = n;
-            while (n0->GetParent()) {
-                n0 = n0->GetParent();
-                Vertex * v0 = n0->GetVertex();
-                if (x2 == v0->GetX() && y2 == v0->GetY()) {
-                    isNeighbour = false;
-                    break;
-                }
-            }
-            if (isNeighbour)
-                neighbours.push_back(itsEdges[i]);
-        }
-    }
+    ULONG id = n->GetVertex()->GetID();
+    for (ULONG i = itsOutStart[id]; i < itsOutStart[id + 1]; i++)
+        if (!n->HasAncestor(itsOutEdges[i]->GetVertex2()))
+            neighbours.push_back(itsOutEdges[i]);
 
     return neighbours;
 }
 
 Vertex ** Graph::GenerateVertices(const vector<XY> &vertices) {
     numVertices = (ULONG)vertices.size();
+    itsLocationIndex = easymath::PointIndex(vertices);
     Vertex ** allVertices = new Vertex *[numVertices];
 
     for (ULONG i = 0; i < numVertices; i++) {
         double x = vertices[i].x;
         double y = vertices[i].y;
 
-        allVertices[i] = new Vertex(x, y);
+        allVertices[i] = new Vertex(x, y, i);
     }
 
     return allVertices;
@@ -153,6 +109,20 @@ Edge ** Graph::GenerateEdges(const vector<edge> &edges) {
     return allEdges;
 }
 
+void Graph::GenerateAdjacency(const vector<edge> &edges) {
+    // Counting sort of edges by source vertex, stable in edge order
+    itsOutStart.assign(numVertices + 1, 0);
+    for (ULONG i = 0; i < numEdges; i++)
+        itsOutStart[(ULONG)edges[i].first + 1]++;
+    for (ULONG i = 0; i < numVertices; i++)
+        itsOutStart[i + 1] += itsOutStart[i];
+
+    itsOutEdges.resize(numEdges);
+    vector<ULONG> next(itsOutStart.begin(), itsOutStart.end() - 1);
+    for (ULONG i = 0; i < numEdges; i++)
+        itsOutEdges[next[(ULONG)edges[i].first]++] = itsEdges[i];
+}
+
 void Node::DisplayPath() {
     cout << "Vertex: (" << itsVertex->GetX() << "," << itsVertex->GetY();
     cout << ")\n";
@@ -165,14 +135,14 @@ void Node::DisplayPath() {
         itsParent->DisplayPath();
 }
 
-Node * Node::ReverseList(Node * itsChild) {
-    Node * itsParentR = new Node(GetVertex());
+Node * Node::ReverseList(Node * itsChild, NodeArena<Node> * arena) {
+    Node * itsParentR = arena->create(GetVertex());
     itsParentR->SetMeanCost(GetMeanCost());
     itsParentR->SetVarCost(GetVarCost());
     itsParentR->SetParent(itsChild);
 
     if (GetParent()) {
-        Node * itsReverse = GetParent()->ReverseList(itsParentR);
+        Node * itsReverse = GetParent()->ReverseList(itsParentR, arena);
         return itsReverse;
     } else {
         return itsParentR;
@@ -192,38 +162,52 @@ void ryan::Queue::UpdateQueue(Node * newNode) {
     // if closed contains node with same vertex, compare their costs
     // choose whether or not to create a new node
 
-    bool dom = false;
-    for (ULONG i = 0; i < closed.size(); i++) {
-        if (closed[i]->GetVertex() == newNode->GetVertex()) {
-            dom = CompareNodes(newNode, closed[i]);
-            if (dom) {
-                delete newNode;
-                newNode = 0;
-                return;
-            }
-        }
-    }
+    if (IsDominated(newNode))
+        return;
     itsPQ->push(newNode);
 }
 
 Node * ryan::Queue::PopQueue() {
     // Check if next node is already dominated by existing node in closed set
     Node * newNode = itsPQ->top();
-    bool dom = false;
-    for (ULONG i = 0; i < closed.size(); i++) {
-        if (closed[i]->GetVertex() == newNode->GetVertex()) {
-            dom = CompareNodes(newNode, closed[i]);
-            if (dom) {
-                delete newNode;
-                newNode = 0;
-                itsPQ->pop();
-                return 0;
-            }
-        }
-    }
-    closed.push_back(itsPQ->top());
     itsPQ->pop();
-    return closed[(ULONG)closed.size() - 1];
+    if (IsDominated(newNode))
+        return 0;
+    Close(newNode);
+    return newNode;
+}
+
+static bool MeanLess(double mean, const Node * n) {
+    return mean < n->GetMeanCost();
+}
+
+static bool MeanLessNode(const Node * n, double mean) {
+    return n->GetMeanCost() < mean;
+}
+
+bool ryan::Queue::IsDominated(const Node * n) const {
+    // Of the front nodes with mean cost no greater than n's, the last has
+    // the least variance; if it does not dominate n, none of them do
+    const vector<Node *> &front = itsFronts[n->GetVertex()->GetID()];
+    auto after = std::upper_bound(front.begin(), front.end(),
+        n->GetMeanCost(), MeanLess);
+    if (after == front.begin())
+        return false;
+    return CompareNodes(n, *std::prev(after));
+}
+
+void ryan::Queue::Close(Node * n) {
+    closed.push_back(n);
+
+    // Front nodes that n dominates form a run starting at n's mean cost
+    vector<Node *> &front = itsFronts[n->GetVertex()->GetID()];
+    auto first = std::lower_bound(front.begin(), front.end(),
+        n->GetMeanCost(), MeanLessNode);
+    auto last = first;
+    while (last != front.end() && CompareNodes(*last, n))
+        ++last;
+    first = front.erase(first, last);
+    front.insert(first, n);
 }
 
 bool ryan::Queue::CompareNodes(const Node * n1, const Node * n2) const {
@@ -246,13 +230,13 @@ bool ryan::Queue::CompareNodes(const Node * n1, const Node * n2) const {
 
 vector<Node *> Search::PathSearch(pathOut pType) {
     ULONG sourceID = FindSourceID();
-    itsQueue
-        = new ryan::Queue(new Node(itsGraph->GetVertices()[sourceID], SOURCE));
+    delete itsQueue;
+    itsNodes.reset();
+    itsQueue = new ryan::Queue(
+        itsNodes.create(itsGraph->GetVertices()[sourceID], SOURCE),
+        itsGraph->GetNumVertices());
 
-    clock_t t_start = clock();
-    double t_elapse = 0.0;
-
-    while (!itsQueue->EmptyQueue() && t_elapse < 5.0) {
+    while (!itsQueue->EmptyQueue() && itsNodes.size() < k_node_budget) {
         // Pop cheapest node from queue
         Node * currentNode = itsQueue->PopQueue();
         if (!currentNode) {
@@ -272,55 +256,35 @@ vector<Node *> Search::PathSearch(pathOut pType) {
         for (ULONG i = 0; i < (ULONG)neighbours.size(); i++) {
             // Check if neighbour vertex is already in closed set
             bool newNeighbour = true;
-            if (pType == BEST) {
-                Vertex * vcheck = neighbours[i]->GetVertex2();
-                for (ULONG j = 0; j < itsQueue->GetClosed().size(); j++) {
-                    if (itsQueue->GetClosed()[j]->GetVertex() == vcheck) {
-                        newNeighbour = false;
-                        break;
-                    }
-                }
-            }
+            if (pType == BEST)
+                newNeighbour = !itsQueue->IsClosed(neighbours[i]->GetVertex2());
 
             if (newNeighbour) {
                 // Create neighbour node
-                Node * currentNeighbour = new Node(currentNode, neighbours[i]);
+                Node * currentNeighbour
+                    = itsNodes.create(currentNode, neighbours[i]);
                 UpdateNode(currentNeighbour);
                 itsQueue->UpdateQueue(currentNeighbour);
             }
         }
-
-        t_elapse = static_cast<float>(clock() - t_start) / CLOCKS_PER_SEC;
     }
 
-    if (t_elapse >= 5.0)
-        printf("Search timed out!\n");
+    if (itsNodes.size() >= k_node_budget)
+        printf("Search exceeded its node budget!\n");
 
     // Check if a path is found
-    bool ClosedAll = false;
-    for (ULONG i = 0; i < itsQueue->GetClosed().size(); i++) {
-        if (itsQueue->GetClosed()[i]->GetVertex() == itsGoal) {
-            ClosedAll = true;
-            break;
-        }
-    }
-
-    if (!ClosedAll) {
+    if (!itsQueue->IsClosed(itsGoal)) {
         cout << "No path found from source to goal.\n";
         vector<Node *> bestPath;
         return bestPath;
     } else {
-        ULONG k = 0;
-        vector<Node *> bestPath((ULONG)itsQueue->GetClosed().size());
+        const vector<Node *> &closed = itsQueue->GetClosed();
+        vector<Node *> bestPath;
 
-        for (ULONG i = 0; i < (ULONG)itsQueue->GetClosed().size(); i++) {
-            if (itsGoal == itsQueue->GetClosed()[i]->GetVertex()) {
-                bestPath[k] = itsQueue->GetClosed()[i];
-                k++;
-            }
-        }
+        for (ULONG i = 0; i < (ULONG)closed.size(); i++)
+            if (itsGoal == closed[i]->GetVertex())
+                bestPath.push_back(closed[i]);
 
-        bestPath.resize(k);
         return bestPath;
     }
 }
@@ -371,81 +335,198 @@ void Search::UpdateNode(Node * n) {
     }
 }
 
-vector<double> linspace(double a, double b, int n) {
-    vector<double> array;
-    double step = (b - a) / (n - 1);
-    while (a <= b) {
-        array.push_back(a);
-        a += step;
-    }
-    return array;
-}
-
-// Function to compare vertices: returns TRUE if vertex A
-// is better than vertex B
-double ComputeImprovementProbability(Vertex * A, Vertex * B) {
-    vector<Node *> ANodes = A->GetNodes();
-    vector<Node *> BNodes = B->GetNodes();
-
-    double c_A0 = A->GetCTC();
-    double c_B0 = B->GetCTC();
-    double max_3sig = ANodes[0]->GetMeanCTG() + 3 * ANodes[0]->GetVarCTG();
-    double min_3sig = ANodes[0]->GetMeanCTG() - 3 * ANodes[0]->GetVarCTG();
-    for (unsigned i = 0; i < ANodes.size(); i++) {
-        if (max_3sig < ANodes[i]->GetMeanCTG() + 3 * ANodes[i]->GetVarCTG())
-            max_3sig = ANodes[i]->GetMeanCTG() + 3 * ANodes[i]->GetVarCTG();
-        if (min_3sig > ANodes[i]->GetMeanCTG() - 3 * ANodes[i]->GetVarCTG())
-            min_3sig = ANodes[i]->GetMeanCTG() - 3 * ANodes[i]->GetVarCTG();
-    }
-    for (unsigned i = 0; i < BNodes.size(); i++) {
-        if (max_3sig < BNodes[i]->GetMeanCTG() + 3 * BNodes[i]->GetVarCTG())
-            max_3sig = BNodes[i]->GetMeanCTG() + 3 * BNodes[i]->GetVarCTG();
-        if (min_3sig > BNodes[i]->GetMeanCTG() - 3 * BNodes[i]->GetVarCTG())
-            min_3sig = BNodes[i]->GetMeanCTG() - 3 * BNodes[i]->GetVarCTG();
-    }
-
-    // If code is taking too long, change n to a smaller value
-    // Note that since this is the numerical integration discretisation
-    // smaller n will provide coarser approximation to solution
-    int n = 100;
-    vector<double> x = linspace(min_3sig, max_3sig, n);
-    double dx = x[1] - x[0];
-    double pImprove = 0.0;
-    for (unsigned k = 0; k < x.size(); k++) {
-        double p_cAi = 0.0;
-        for (unsigned i = 0; i < ANodes.size(); i++) {
-            double mu_Ai = ANodes[i]->GetMeanCTG();
-            double sig_Ai = ANodes[i]->GetVarCTG();
-            double p_cA1 = (1 / (sig_Ai*sqrt(2 * pi)))
-                *exp(-(pow(x[k] - mu_Ai, 2)) / (2 * pow(sig_Ai, 2)));
-            double p_cA2 = 1.0;
-            for (unsigned j = 0; j < ANodes.size(); j++) {
-                double mu_Aj = ANodes[j]->GetMeanCTG();
-                double sig_Aj = ANodes[j]->GetVarCTG();
-                if (j != i)
-                    p_cA2 *= 0.5*erfc((x[k] - mu_Aj) / (sig_Aj*sqrt(2)));
-            }
-            p_cAi += p_cA1*p_cA2;
-        }
-        double p_cBi = 1.0;
-        for (unsigned i = 0; i < BNodes.size(); i++) {
-            double mu_Bi = BNodes[i]->GetMeanCTG();
-            double sig_Bi = BNodes[i]->GetVarCTG();
-            p_cBi *= 0.5
-                *erfc((x[k] - (c_B0 - c_A0) - mu_Bi) / (sig_Bi*sqrt(2)));
-        }
-        pImprove += (p_cAi)*(1 - p_cBi)*dx;
+// Normal distribution of total cost to the goal along one path. A path with
+// no variance is a point mass at its mean.
+struct CostDist {
+    double mean, sigma;
+};
+
+// Total cost through v along each of its nodes' paths
+static vector<CostDist> TotalCosts(Vertex * v) {
+    vector<Node *> nodes = v->GetNodes();
+    vector<CostDist> d(nodes.size());
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        d[i].mean = v->GetCTC() + nodes[i]->GetMeanCTG();
+        d[i].sigma = nodes[i]->GetVarCTG();
+    }
+    return d;
+}
+
+// Adds one path to the density and survival function of the least cost
+// over the paths before it: the density of min(c, C) is f_c*S_C + f_C*S_c.
+// A point mass adds no density; its survival steps from 1 to 0 at the mean,
+// taking the value tie there.
+static void AddPath(const CostDist &d, double y, double * pdf,
+    double * survival, double tie = 0.5) {
+    double p = 0.0, s;
+    if (d.sigma > 0) {
+        double z = (y - d.mean) / d.sigma;
+        p = exp(-0.5*z*z) / (d.sigma*sqrt(2 * pi));
+        s = 0.5*erfc(z / sqrt(2));
+    } else {
+        s = y < d.mean ? 1.0 : (y > d.mean ? 0.0 : tie);
+    }
+    *pdf = *pdf*s + p**survival;
+    *survival *= s;
+}
+
+// Density and survival function of the least total cost at y
+static void LeastCostAt(const vector<CostDist> &d, double y, double * pdf,
+    double * survival, double tie = 0.5) {
+    *pdf = 0.0;
+    *survival = 1.0;
+    for (unsigned i = 0; i < d.size(); i++)
+        AddPath(d[i], y, pdf, survival, tie);
+}
+
+// Part of the improvement probability held in A's point masses, which the
+// density misses: at each atom y the least cost of A has mass
+// S_A(y-) - S_A(y+), and B costs less than y with probability 1 - S_B(y),
+// ties counting half
+static double PointMassImprovement(const vector<CostDist> &a,
+    const vector<CostDist> &b) {
+    vector<double> atoms;
+    for (unsigned i = 0; i < a.size(); i++)
+        if (!(a[i].sigma > 0))
+            atoms.push_back(a[i].mean);
+    std::sort(atoms.begin(), atoms.end());
+    atoms.erase(std::unique(atoms.begin(), atoms.end()), atoms.end());
+
+    double p = 0.0;
+    for (unsigned i = 0; i < atoms.size(); i++) {
+        double f, s_a_below, s_a_above, s_b;
+        LeastCostAt(a, atoms[i], &f, &s_a_below, 1.0);
+        LeastCostAt(a, atoms[i], &f, &s_a_above, 0.0);
+        LeastCostAt(b, atoms[i], &f, &s_b);
+        p += (s_a_below - s_a_above)*(1.0 - s_b);
+    }
+    return p;
+}
+
+// Range holding the bulk of every path's cost (3 sigma either side)
+static void CostRange(const vector<CostDist> &d, double * lo, double * hi) {
+    for (unsigned i = 0; i < d.size(); i++) {
+        *lo = std::min(*lo, d[i].mean - 3 * d[i].sigma);
+        *hi = std::max(*hi, d[i].mean + 3 * d[i].sigma);
+    }
+}
+
+ImprovementTable::ImprovementTable(const vector<Vertex *> &vertices,
+    ULONG samples) : itsStep(0.0) {
+    vector<vector<CostDist> > costs(vertices.size());
+    for (unsigned v = 0; v < vertices.size(); v++)
+        costs[v] = TotalCosts(vertices[v]);
+    itsPointMass.assign(vertices.size(), vector<double>(vertices.size()));
+    for (unsigned i = 0; i < costs.size(); i++)
+        for (unsigned j = 0; j < costs.size(); j++)
+            itsPointMass[i][j] = PointMassImprovement(costs[i], costs[j]);
+
+    // One grid covers all vertices, as finely as the narrowest one needs
+    double lo = DBL_MAX, hi = -DBL_MAX;
+    for (unsigned v = 0; v < costs.size(); v++) {
+        double lo_v = DBL_MAX, hi_v = -DBL_MAX;
+        CostRange(costs[v], &lo_v, &hi_v);
+        lo = std::min(lo, lo_v);
+        hi = std::max(hi, hi_v);
+        double step = (hi_v - lo_v) / (samples - 1);
+        if (step > 0 && (itsStep == 0.0 || step < itsStep))
+            itsStep = step;
+    }
+    ULONG n = 1;
+    if (itsStep > 0) {
+        double max_n = static_cast<double>(samples*vertices.size());
+        n = static_cast<ULONG>(std::min((hi - lo) / itsStep, max_n)) + 1;
+        itsStep = (hi - lo) / std::max<ULONG>(n - 1, 1);
+    }
+
+    itsDensity.assign(vertices.size(), vector<double>(n, 0.0));
+    itsSurvival.assign(vertices.size(), vector<double>(n, 1.0));
+    for (unsigned v = 0; v < costs.size(); v++) {
+        double * pdf = itsDensity[v].data();
+        double * survival = itsSurvival[v].data();
+        for (unsigned i = 0; i < costs[v].size(); i++)
+            for (ULONG k = 0; k < n; k++)
+                AddPath(costs[v][i], lo + k*itsStep, pdf + k, survival + k);
     }
+}
 
-    return pImprove;
+double ImprovementTable::Probability(ULONG i, ULONG j) const {
+    // Integral of f_i(y) * P(cost_j < y)
+    const vector<double> &f = itsDensity[i];
+    const vector<double> &s = itsSurvival[j];
+    double p = 0.0;
+    for (ULONG k = 0; k < f.size(); k++)
+        p += f[k] * (1.0 - s[k]);
+    return p*itsStep + itsPointMass[i][j];
 }
 
-// Function to compare vertices: returns TRUE if vertex A
-// is better than vertex B
-bool IsABetterThanB(Vertex * A, Vertex * B) {
-    double pImprove = ComputeImprovementProbability(A, B);
+// Integrand of the improvement probability, f_A(y) * P(cost_B < y)
+static double Improvement(const vector<CostDist> &a,
+    const vector<CostDist> &b, double y) {
+    double f_a, s_a, f_b, s_b;
+    LeastCostAt(a, y, &f_a, &s_a);
+    LeastCostAt(b, y, &f_b, &s_b);
+    return f_a*(1.0 - s_b);
+}
 
-    return (pImprove <= 0.5);
+// Deep enough to resolve a jump in the integrand to 2^-20 of a piece
+static const int k_max_depth = 20;
+
+static double AdaptiveSimpson(const vector<CostDist> &a,
+    const vector<CostDist> &b, double lo, double hi, double f_lo,
+    double f_mid, double f_hi, double whole, double tolerance, int depth) {
+    double mid = 0.5*(lo + hi);
+    double f_left = Improvement(a, b, 0.5*(lo + mid));
+    double f_right = Improvement(a, b, 0.5*(mid + hi));
+    double left = (mid - lo) / 6 * (f_lo + 4 * f_left + f_mid);
+    double right = (hi - mid) / 6 * (f_mid + 4 * f_right + f_hi);
+    double diff = left + right - whole;
+    if (!std::isfinite(diff))
+        return left + right;
+    if (depth <= 0 || fabs(diff) <= 15 * tolerance)
+        return left + right + diff / 15;
+    return AdaptiveSimpson(a, b, lo, mid, f_lo, f_left, f_mid, left,
+        tolerance / 2, depth - 1)
+        + AdaptiveSimpson(a, b, mid, hi, f_mid, f_right, f_hi, right,
+            tolerance / 2, depth - 1);
+}
+
+double ComputeImprovementProbability(Vertex * A, Vertex * B,
+    double tolerance) {
+    vector<CostDist> a = TotalCosts(A);
+    vector<CostDist> b = TotalCosts(B);
+    double p = PointMassImprovement(a, b);
+
+    // The integrand vanishes outside the range of A's costs
+    double lo = DBL_MAX, hi = -DBL_MAX;
+    CostRange(a, &lo, &hi);
+    if (!(hi > lo))
+        return p;
+
+    // Start from pieces no wider than the narrowest distribution, so that
+    // no peak falls between the first samples
+    double width = hi - lo;
+    for (unsigned i = 0; i < a.size(); i++)
+        if (a[i].sigma > 0)
+            width = std::min(width, a[i].sigma);
+    for (unsigned i = 0; i < b.size(); i++)
+        if (b[i].sigma > 0)
+            width = std::min(width, b[i].sigma);
+    int pieces = static_cast<int>(std::min(ceil((hi - lo) / width), 1000.0));
+    pieces = std::max(pieces, 1);
+
+    double step = (hi - lo) / pieces;
+    for (int i = 0; i < pieces; i++) {
+        double l = lo + i*step;
+        double h = l + step;
+        double f_l = Improvement(a, b, l);
+        double f_m = Improvement(a, b, 0.5*(l + h));
+        double f_h = Improvement(a, b, h);
+        double whole = step / 6 * (f_l + 4 * f_m + f_h);
+        p += AdaptiveSimpson(a, b, l, h, f_l, f_m, f_h, whole,
+            tolerance / pieces, k_max_depth);
+    }
+    return p;
 }
 
 void RAGS::SetInitialVert(Vertex * start) {
@@ -458,23 +539,10 @@ void RAGS::SetInitialVert(Vertex * start) {
 
 // Create function that converts from XY to Vertex *
 XY RAGS::SearchGraph(const XY& start, const XY& goal, const matrix1d& weights) {
-    Vertex ** allVerts = itsGraph->GetVertices();
-    Vertex * sVert = NULL;
-    Vertex * gVert = NULL;
-    bool sFound = false;
-    bool gFound = false;
-    for (ULONG i = 0; i < itsGraph->GetNumVertices(); i++) {
-        if (start.x == allVerts[i]->GetX() && start.y == allVerts[i]->GetY()) {
-            sVert = allVerts[i];
-            sFound = true;
-        }
-    }
-    for (ULONG i = 0; i < itsGraph->GetNumVertices(); i++) {
-        if (goal.x == allVerts[i]->GetX() && goal.y == allVerts[i]->GetY()) {
-            gVert = allVerts[i];
-            gFound = true;
-        }
-    }
+    Vertex * sVert = itsGraph->FindVertex(start);
+    Vertex * gVert = itsGraph->FindVertex(goal);
+    bool sFound = sVert != NULL;
+    bool gFound = gVert != NULL;
     if (!sFound) {
         printf("ERROR: start vertex (%f,%f) not found. ", start.x, start.y);
         printf("Exiting.\n");
@@ -498,6 +566,8 @@ XY RAGS::SearchGraph(Vertex * start, Vertex * goal, const matrix1d &weights) {
 
     // Initialise non-dominated path set
     if (itsNDSet.empty()) {
+        delete itsSearch;
+        itsNDNodes.reset();
         itsSearch = new Search(itsGraph, start, goal);
         vector<Node *> GSPaths = itsSearch->PathSearch(PSET);
 
@@ -507,7 +577,7 @@ XY RAGS::SearchGraph(Vertex * start, Vertex * goal, const matrix1d &weights) {
         }
 
         for (ULONG i = 0; i < (ULONG)GSPaths.size(); i++)
-            itsNDSet.push_back(GSPaths[i]->ReverseList(0));
+            itsNDSet.push_back(GSPaths[i]->ReverseList(0, &itsNDNodes));
 
         for (ULONG i = 0; i < (ULONG)itsNDSet.size(); i++)
             itsNDSet[i]->SetCTG(GSPaths[i]->GetMeanCost(),
@@ -525,96 +595,182 @@ XY RAGS::SearchGraph(Vertex * start, Vertex * goal, const matrix1d &weights) {
         return s;
     }
 
-    vector<Node *> newNodes = itsNDSet;
-    itsVert->SetNodes(newNodes);
-    vector<Node *> tmpNodes;
-    vector<Node *> noNodes;  // keep track of unvisited nodes
-    vector<Vertex *> nextVerts;
+    itsVert->SetNodes(itsNDSet);
+    Vertex * next = SelectNextVertex(itsVert, itsNDSet);
+    if (!next) {
+        XY s = XY(itsVert->GetX(), itsVert->GetY());
+        return s;  // at the goal, stay where you are
+    }
+    itsVert = next;
+
+    // Nodes of the other vertices are dropped here and reclaimed with
+    // itsNDNodes when the next initial search runs
+    itsNDSet = itsVert->GetNodes();
+    XY vertXY = XY(itsVert->GetX(), itsVert->GetY());
+    return vertXY;
+}
 
+Vertex * RAGS::SelectNextVertex(Vertex * vert, const vector<Node *> &nodes) {
     // Identify next vertices
-    for (unsigned i = 0; i < newNodes.size(); i++) {
-        bool newVert = true;
-        for (unsigned j = 0; j < nextVerts.size(); j++) {
-            if (nextVerts[j] == newNodes[i]->GetParent()->GetVertex()
-                || nextVerts[j] == itsVert) {
-                newVert = false;
-                break;
-            }
-        }
-        if (newVert)
-            nextVerts.push_back(newNodes[i]->GetParent()->GetVertex());
+    vector<Vertex *> nextVerts;
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        if (!nodes[i]->GetParent())
+            continue;
+        Vertex * v = nodes[i]->GetParent()->GetVertex();
+        if (std::find(nextVerts.begin(), nextVerts.end(), v)
+            == nextVerts.end())
+            nextVerts.push_back(v);
     }
+    if (nextVerts.empty())
+        return NULL;
 
     // Identify next vertex path nodes
+    vector<Node *> tmpNodes;
     for (unsigned i = 0; i < nextVerts.size(); i++) {
         tmpNodes.clear();
-        for (unsigned j = 0; j < newNodes.size(); j++)
-            if (nextVerts[i] == newNodes[j]->GetParent()->GetVertex())
-                tmpNodes.push_back(newNodes[j]->GetParent());
-            else
-                noNodes.push_back(newNodes[j]->GetParent());
+        for (unsigned j = 0; j < nodes.size(); j++)
+            if (nodes[j]->GetParent()
+                && nextVerts[i] == nodes[j]->GetParent()->GetVertex())
+                tmpNodes.push_back(nodes[j]->GetParent());
         nextVerts[i]->SetNodes(tmpNodes);
     }
 
-    // Rank next vertices according to probability of improvement
-    sort(nextVerts.begin(), nextVerts.end(), IsABetterThanB);
-    itsVert = nextVerts[0];
-
-    // Delete nodes of vertices that will not be considered along entire
-    // link list
-    for (unsigned i = 1; i < nextVerts.size(); i++) {
-        vector<Node *> nN = nextVerts[i]->GetNodes();
-        for (unsigned j = 0; j < nN.size(); j++) {
-            Node * hN;
-            Node * pN = nN[j]->GetParent();
-            while (pN) {
-                hN = pN->GetParent();
-                delete pN;
-                pN = hN;
-            }
-            delete nN[j];
-            nN[j] = 0;
-        }
+    // Move to the next vertex least likely to be improved on
+    return nextVerts[RankNextVertices(vert, nextVerts)];
+}
+
+void RAGS::UpdateEdgeCosts(const matrix1d &weights) {
+    AssignCurrentEdgeCosts(weights);
+    AssignCurrentMeansAndVariances();
+    if (weights == itsLastWeights)
+        return;
+    itsLastWeights = weights;
+
+    // Path sets are searched again, on first use, with the statistics as
+    // they are now; cursors into the old sets restart
+    Edge ** e = itsGraph->GetEdges();
+    for (ULONG i = 0; i < itsGraph->GetNumEdges(); i++) {
+        e[i]->SetMeanSearch(e[i]->GetMeanCost());
+        e[i]->SetVarSearch(e[i]->GetVarCost());
     }
+    itsPathSets.clear();
+    itsPathSetNodes.reset();
+    itsGeneration++;
+}
+
+const vector<Node *>& RAGS::GetPathSet(Vertex * start, Vertex * goal) {
+    std::pair<ULONG, ULONG> key(start->GetID(), goal->GetID());
+    auto found = itsPathSets.find(key);
+    if (found != itsPathSets.end())
+        return found->second;
+
+    vector<Node *> &paths = itsPathSets[key];
+    Search search(itsGraph, start, goal);
+    vector<Node *> GSPaths = search.PathSearch(ALL);
+    for (ULONG i = 0; i < (ULONG)GSPaths.size(); i++) {
+        paths.push_back(GSPaths[i]->ReverseList(0, &itsPathSetNodes));
+        paths.back()->SetCTG(GSPaths[i]->GetMeanCost(),
+            GSPaths[i]->GetVarCost());
+    }
+    return paths;
+}
 
-    // Delete old NDSet
-    for (unsigned i = 0; i < itsNDSet.size(); i++) {
-        delete itsNDSet[i];
-        itsNDSet[i] = 0;
+bool RAGS::PlanPath(Cursor * cursor, ULONG start, ULONG goal,
+    vector<size_t> * path) {
+    Vertex * s = itsGraph->GetVertices()[start];
+    Vertex * g = itsGraph->GetVertices()[goal];
+    Cursor &c = *cursor;
+    bool stale = c.itsGeneration != itsGeneration;
+    c.itsGeneration = itsGeneration;
+    path->clear();
+
+    if (c.itsGoal == g && c.itsVert != s && c.itsNext == s && c.itsAhead) {
+        // Reached the end of the link; the traveller has already taken the
+        // vertex chosen beyond it
+        c.itsVert = s;
+        c.itsNext = c.itsAhead;
+        c.itsNextNodes = c.itsAheadNodes;
+    } else if (c.itsGoal != g || c.itsVert != s || !c.itsNext) {
+        c.itsGoal = g;
+        c.itsVert = s;
+        c.itsNext = SelectNextVertex(s, GetPathSet(s, g));
+        if (!c.itsNext)
+            return start == goal ? (path->push_back(start), true) : false;
+        c.itsNextNodes = c.itsNext->GetNodes();
+        stale = false;
+    }
+    if (stale)
+        c.itsNextNodes = GetPathSet(c.itsNext, g);
+
+    // Choose again, with the latest costs, where to go after the next
+    // vertex; the rest follows the cheapest expected path from there
+    path->push_back(start);
+    path->push_back(c.itsNext->GetID());
+    c.itsAhead = SelectNextVertex(c.itsNext, c.itsNextNodes);
+    if (!c.itsAhead)
+        return true;
+    c.itsAheadNodes = c.itsAhead->GetNodes();
+
+    Node * best = NULL;
+    for (unsigned i = 0; i < c.itsAheadNodes.size(); i++)
+        if (!best || c.itsAheadNodes[i]->GetMeanCTG() < best->GetMeanCTG())
+            best = c.itsAheadNodes[i];
+    for (Node * n = best; n; n = n->GetParent())
+        path->push_back(n->GetVertex()->GetID());
+    return true;
+}
+
+ULONG RAGS::RankNextVertices(Vertex * vert,
+    const vector<Vertex *> &nextVerts) {
+    // Cost-to-come of each next vertex is the observed cost of its edge
+    vector<Edge *> out = itsGraph->GetNeighbours(vert);
+    for (unsigned i = 0; i < out.size(); i++)
+        out[i]->GetVertex2()->SetCTC(out[i]->GetTrueCost());
+
+    // A single pass keeps the first vertex that no later one is more likely
+    // than not to improve on
+    ULONG best = 0;
+    if (QUAD == TABULATED) {
+        ImprovementTable table(nextVerts);
+        for (ULONG i = 1; i < nextVerts.size(); i++)
+            if (table.Probability(best, i) > 0.5)
+                best = i;
+    } else {
+        for (ULONG i = 1; i < nextVerts.size(); i++)
+            if (ComputeImprovementProbability(nextVerts[best], nextVerts[i],
+                k_quad_tolerance) > 0.5)
+                best = i;
     }
-    itsNDSet.clear();
-    itsNDSet = itsVert->GetNodes();
-    XY vertXY = XY(itsVert->GetX(), itsVert->GetY());
-    return vertXY;
+    return best;
 }
 
 void RAGS::AssignCurrentMeansAndVariances() {
-    size_t T = weights_history.size();  // length of time this has been running
-    size_t E = weights_history[0].size();  // number of edges
+    size_t E = itsCostMean.size();  // number of edges
     Edge ** edges = itsGraph->GetEdges();
 
     for (size_t e = 0; e < E; e++) {
-        double sum = 0, mu = 0, sigma_sq = 0, sdev = 0;
-        vector<double> h(T, 0.0);
-        for (size_t t = 0; t < T; t++) {
-            h[t] = weights_history[t][e];
-        }
-
-        sum = accumulate(h.begin(), h.end(), 0.0);
-        mu = sum / T;
-
-        sdev = std::inner_product(h.begin(), h.end(), h.begin(), 0.0);
-        sigma_sq = sdev / T - mu*mu;
-
-        edges[e]->SetMeanCost(mu);
-        edges[e]->SetVarCost(sigma_sq);
+        edges[e]->SetMeanCost(itsCostMean[e]);
+        edges[e]->SetVarCost(itsCostVar[e]);
     }
 }
 
 
 void RAGS::AssignCurrentEdgeCosts(const matrix1d &weights) {
-    // Record weight for later mean/var calculations
-    weights_history.push_back(weights);
+    // Fold weights into the running mean/var of each edge's cost. Welford's
+    // update weights sample t by 1/t; with forgetting, recent samples keep
+    // at least that weight, so older ones decay exponentially.
+    if (itsCostCount == 0) {
+        itsCostMean.assign(weights.size(), 0.0);
+        itsCostVar.assign(weights.size(), 0.0);
+    }
+    itsCostCount++;
+    double alpha = std::max(1.0 / itsCostCount, itsForgetting);
+    for (size_t e = 0; e < weights.size(); e++) {
+        double diff = weights[e] - itsCostMean[e];
+        itsCostMean[e] += alpha*diff;
+        itsCostVar[e] = (1.0 - alpha)*(itsCostVar[e] + alpha*diff*diff);
+    }
+
     ULONG n = itsGraph->GetNumEdges();
     Edge ** e = itsGraph->GetEdges();
 
@@ -623,22 +779,12 @@ void RAGS::AssignCurrentEdgeCosts(const matrix1d &weights) {
 }
 
 int RAGS::GetEdgeIndex(XY start, XY goal) {
-    int startID;
-    int goalID;
-    bool foundStart = false;
-    bool foundGoal = false;
-    for (unsigned i = 0; i < itsLocations.size(); i++) {
-        if (start == itsLocations[i]) {
-            startID = i;
-            foundStart = true;
-        }
-        if (goal == itsLocations[i]) {
-            goalID = i;
-            foundGoal = true;
-        }
-        if (foundStart && foundGoal)
-            break;
-    }
+    size_t startIndex = itsGraph->FindVertexIndex(start);
+    size_t goalIndex = itsGraph->FindVertexIndex(goal);
+    bool foundStart = startIndex != easymath::PointIndex::npos;
+    bool foundGoal = goalIndex != easymath::PointIndex::npos;
+    int startID = static_cast<int>(startIndex);
+    int goalID = static_cast<int>(goalIndex);
     if (!foundStart) {
         cout << "ERROR: Did not find current vertex index.\n";
         exit(1);
@@ -0,0 +1,92 @@
+// Copyright 2016 Carrie Rebhuhn
+/**
+* Checks Link::predictedTraversalTime against the formula it replaced: sort
+* the waits of every UAV on the link, keep the longest
+* min(n, 2*(capacity-1)) of them, and add their sum to the link time. Runs
+* random sequences of UAVs entering, leaving early, and the clock moving on,
+* over a range of capacities and link times. Exits nonzero on a mismatch.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+#include "Domains/UTM/Link.h"
+#include "Math/include/Random.h"
+
+using std::vector;
+using easymath::XY;
+using easymath::rand_index;
+
+namespace {
+//! The original sort-and-pop formula
+double sortedWaitTime(const vector<UAV*> &traffic, size_t capacity,
+    size_t time, size_t now) {
+    vector<double> waits;
+    for (UAV* u : traffic)
+        waits.push_back(static_cast<double>(u->getWait(now)));
+    std::sort(waits.begin(), waits.end(), std::greater<double>());
+
+    size_t n_ok = capacity - 1;
+    if (waits.size() >= 2 * n_ok)
+        waits.resize(2 * n_ok);
+    return static_cast<double>(time) + easymath::sum(waits);
+}
+}  // namespace
+
+int main() {
+    // UAV reads its search mode from the working directory
+    if (!std::ifstream("config.yaml"))
+        std::ofstream("config.yaml") << "modes:\n  search: astar\n";
+
+    vector<XY> locs = { XY(0, 0), XY(10, 0) };
+    vector<LinkGraph::edge> edges = { LinkGraph::edge(0, 1) };
+    LinkGraph graph(locs, edges);
+
+    easymath::seed(5);
+    size_t n_checks = 0, n_bad = 0;
+    for (size_t trial = 0; trial < 300; trial++) {
+        size_t time = 1 + rand_index(40);
+        size_t capacity = 1 + rand_index(6);
+
+        ExitCalendar calendar;
+        matrix1d occupancy(1, 0.0);
+        Link link(0, 0, 1, time, capacity, 0, &occupancy, &calendar);
+        vector<UAV*> uavs;
+
+        for (size_t op = 0; op < 400; op++) {
+            size_t r = rand_index(3);
+            if (r == 0 || uavs.empty()) {
+                UAV* u = new UAV(0, 1, &graph);
+                link.add(u);
+                uavs.push_back(u);
+            } else if (r == 1) {
+                size_t i = rand_index(uavs.size());
+                link.remove(uavs[i]);
+                delete uavs[i];
+                uavs[i] = uavs.back();
+                uavs.pop_back();
+            } else {
+                calendar.advance();
+            }
+
+            double expected = sortedWaitTime(link.traffic_, capacity, time,
+                calendar.now());
+            double predicted = link.predictedTraversalTime();
+            n_checks++;
+            if (predicted != expected) {
+                if (n_bad++ < 10)
+                    printf("capacity %zu, time %zu, %zu UAVs: "
+                        "predicted %g, expected %g\n", capacity, time,
+                        uavs.size(), predicted, expected);
+            }
+        }
+        for (UAV* u : uavs)
+            delete u;
+    }
+
+    printf("%zu checks, %zu mismatches\n", n_checks, n_bad);
+    return n_bad == 0 ? 0 : 1;
+}